@@ -71,6 +71,7 @@ create_GistBulkDeleteResult(void)
 	gist_stats->page_set_context =
 		GenerationContextCreate(CurrentMemoryContext,
 								"GiST VACUUM page set context",
+								16 * 1024,
 								16 * 1024);
 
 	return gist_stats;
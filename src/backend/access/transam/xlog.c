@@ -665,6 +665,13 @@ typedef struct XLogCtlData
 	 */
 	bool		WalWriterSleeping;
 
+	/*
+	 * Number of times a backend had to write out a dirty WAL buffer itself,
+	 * because the WAL buffers were full when it needed to initialize a new
+	 * page.
+	 */
+	pg_atomic_uint64 walBuffersFull;
+
 	/*
 	 * recoveryWakeupLatch is used to wake up the startup process to continue
 	 * WAL replay, if it is waiting for WAL to arrive or failover trigger file
@@ -2162,6 +2169,7 @@ AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic)
 				{
 					/* Have to write it ourselves */
 					TRACE_POSTGRESQL_WAL_BUFFER_WRITE_DIRTY_START();
+					pg_atomic_fetch_add_u64(&XLogCtl->walBuffersFull, 1);
 					WriteRqst.Write = OldPageRqstPtr;
 					WriteRqst.Flush = 0;
 					XLogWrite(WriteRqst, false);
@@ -2246,6 +2254,29 @@ AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic)
 	}
 	LWLockRelease(WALBufMappingLock);
 
+	/*
+	 * If more than half of the WAL buffers are now occupied by WAL that
+	 * hasn't been written out yet, ask the WAL writer to write out the
+	 * completed pages.  Otherwise, during bulk loads, the inserting backends
+	 * tend to run into a full buffer cache and have to write out old pages
+	 * themselves, while holding up insertions into the new pages.
+	 */
+	if (!opportunistic && npages > 0 &&
+		NewPageEndPtr - LogwrtResult.Write >
+		(XLogRecPtr) XLOG_BLCKSZ * (XLogCtl->XLogCacheBlck + 1) / 2)
+	{
+		XLogRecPtr	WriteRqstPtr = upto - upto % XLOG_BLCKSZ;
+
+		SpinLockAcquire(&XLogCtl->info_lck);
+		if (XLogCtl->LogwrtRqst.Write < WriteRqstPtr)
+			XLogCtl->LogwrtRqst.Write = WriteRqstPtr;
+		LogwrtResult = XLogCtl->LogwrtResult;
+		SpinLockRelease(&XLogCtl->info_lck);
+
+		if (LogwrtResult.Write < WriteRqstPtr && ProcGlobal->walwriterLatch)
+			SetLatch(ProcGlobal->walwriterLatch);
+	}
+
 #ifdef WAL_DEBUG
 	if (XLOG_DEBUG && npages > 0)
 	{
@@ -5238,6 +5269,7 @@ XLOGShmemInit(void)
 	 */
 	XLogCtl->XLogCacheBlck = XLOGbuffers - 1;
 	XLogCtl->SharedRecoveryState = RECOVERY_STATE_CRASH;
+	pg_atomic_init_u64(&XLogCtl->walBuffersFull, 0);
 	XLogCtl->SharedHotStandbyActive = false;
 	XLogCtl->WalWriterSleeping = false;
 
@@ -11435,6 +11467,16 @@ GetXLogWriteRecPtr(void)
 	return LogwrtResult.Write;
 }
 
+/*
+ * Get the number of times a backend had to write out WAL buffers itself,
+ * because they were all in use, since server start.
+ */
+uint64
+GetXLogBuffersFull(void)
+{
+	return pg_atomic_read_u64(&XLogCtl->walBuffersFull);
+}
+
 /*
  * Returns the redo pointer of the last checkpoint or restartpoint. This is
  * the oldest point in WAL that we still need, if we have to restart recovery.
@@ -11569,6 +11611,17 @@ read_backup_label(XLogRecPtr *checkPointLoc, bool *backupEndRequired,
 						tli_from_file, BACKUP_LABEL_FILE)));
 	}
 
+	/*
+	 * An incremental backup only contains the blocks changed since an
+	 * earlier backup, so it can't be started by itself.  pg_combinebackup
+	 * removes this line when reconstructing a full backup.
+	 */
+	if (fscanf(lfp, "INCREMENTAL FROM LSN: %X/%X\n", &hi, &lo) == 2)
+		ereport(FATAL,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("cannot start from an incremental backup"),
+				 errhint("Use pg_combinebackup to reconstruct a full backup.")));
+
 	if (ferror(lfp) || FreeFile(lfp))
 		ereport(FATAL,
 				(errcode_for_file_access(),
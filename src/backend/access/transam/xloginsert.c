@@ -94,6 +94,22 @@ static char *hdr_scratch = NULL;
 	 MaxSizeOfXLogRecordBlockHeader * (XLR_MAX_BLOCK_ID + 1) + \
 	 SizeOfXLogRecordDataHeaderLong + SizeOfXlogOrigin)
 
+/*
+ * Records whose total length is at most SMALL_RECORD_SIZE are flattened into
+ * 'small_record' by XLogRecordAssemble(), so that the CRC can be computed in
+ * a single pass and CopyXLogRecordToWAL() gets away with a single memcpy()
+ * while holding the WAL insertion lock.  For tiny records, such as heap
+ * inserts of narrow rows, walking a chain of several XLogRecData entries is
+ * a noticeable fraction of the total cost.
+ *
+ * Like hdr_scratch, the buffer is palloc'd at initialization so that it is
+ * MAXALIGNed.
+ */
+#define SMALL_RECORD_SIZE	512
+
+static XLogRecData small_rdt;
+static char *small_record = NULL;
+
 /*
  * An array of XLogRecData structs, to hold registered data.
  */
@@ -474,6 +490,9 @@ XLogInsert(RmgrId rmid, uint8 info)
  * The record header fields are filled in, except for the xl_prev field. The
  * calculated CRC does not include the record header yet.
  *
+ * Small records are returned as a single XLogRecData entry pointing to a
+ * private staging buffer, rather than as a chain.
+ *
  * If there are any registered buffers, and a full-page image was not taken
  * of all of them, *fpw_lsn is set to the lowest LSN among such pages. This
  * signals that the assembled record is only good for insertion on the
@@ -485,6 +504,7 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 				   XLogRecPtr *fpw_lsn)
 {
 	XLogRecData *rdt;
+	XLogRecData *result;
 	uint32		total_len = 0;
 	int			block_id;
 	pg_crc32c	rdata_crc;
@@ -773,11 +793,45 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 	 * don't know the prev-link yet.  Thus, the CRC will represent the CRC of
 	 * the whole record in the order: rdata, then backup blocks, then record
 	 * header.
+	 *
+	 * If the record is small, first flatten the whole chain into the staging
+	 * buffer, and hand that to XLogInsertRecord() as a single XLogRecData.
+	 * The copying is done here, before any lock is acquired, and makes both
+	 * the CRC calculation and the eventual copy into the WAL buffers a
+	 * single contiguous operation.
 	 */
 	INIT_CRC32C(rdata_crc);
-	COMP_CRC32C(rdata_crc, hdr_scratch + SizeOfXLogRecord, hdr_rdt.len - SizeOfXLogRecord);
-	for (rdt = hdr_rdt.next; rdt != NULL; rdt = rdt->next)
-		COMP_CRC32C(rdata_crc, rdt->data, rdt->len);
+	if (total_len <= SMALL_RECORD_SIZE && hdr_rdt.next != NULL)
+	{
+		char	   *dst = small_record;
+
+		memcpy(dst, hdr_scratch, hdr_rdt.len);
+		dst += hdr_rdt.len;
+		for (rdt = hdr_rdt.next; rdt != NULL; rdt = rdt->next)
+		{
+			memcpy(dst, rdt->data, rdt->len);
+			dst += rdt->len;
+		}
+		Assert(dst - small_record == total_len);
+
+		COMP_CRC32C(rdata_crc, small_record + SizeOfXLogRecord,
+					total_len - SizeOfXLogRecord);
+
+		small_rdt.data = small_record;
+		small_rdt.len = total_len;
+		small_rdt.next = NULL;
+
+		rechdr = (XLogRecord *) small_record;
+		result = &small_rdt;
+	}
+	else
+	{
+		COMP_CRC32C(rdata_crc, hdr_scratch + SizeOfXLogRecord, hdr_rdt.len - SizeOfXLogRecord);
+		for (rdt = hdr_rdt.next; rdt != NULL; rdt = rdt->next)
+			COMP_CRC32C(rdata_crc, rdt->data, rdt->len);
+
+		result = &hdr_rdt;
+	}
 
 	/*
 	 * Fill in the fields in the record header. Prev-link is filled in later,
@@ -791,7 +845,7 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 	rechdr->xl_prev = InvalidXLogRecPtr;
 	rechdr->xl_crc = rdata_crc;
 
-	return &hdr_rdt;
+	return result;
 }
 
 /*
@@ -1193,4 +1247,11 @@ InitXLogInsert(void)
 	if (hdr_scratch == NULL)
 		hdr_scratch = MemoryContextAllocZero(xloginsert_cxt,
 											 HEADER_SCRATCH_SIZE);
+
+	/*
+	 * Allocate the staging buffer used to assemble small records.
+	 */
+	if (small_record == NULL)
+		small_record = MemoryContextAllocZero(xloginsert_cxt,
+											  SMALL_RECORD_SIZE);
 }
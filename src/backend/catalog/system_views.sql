@@ -547,6 +547,15 @@ CREATE VIEW pg_config AS
 REVOKE ALL on pg_config FROM PUBLIC;
 REVOKE EXECUTE ON FUNCTION pg_config() FROM PUBLIC;
 
+CREATE VIEW pg_backend_memory_contexts AS
+    SELECT * FROM pg_get_backend_memory_contexts();
+
+REVOKE ALL ON pg_backend_memory_contexts FROM PUBLIC;
+REVOKE EXECUTE ON FUNCTION pg_get_backend_memory_contexts() FROM PUBLIC;
+
+CREATE VIEW pg_backend_catcache_stats AS
+    SELECT * FROM pg_get_backend_catcache_stats();
+
 -- Statistics views
 
 CREATE VIEW pg_stat_all_tables AS
@@ -755,6 +764,17 @@ CREATE VIEW pg_stat_activity AS
         LEFT JOIN pg_database AS D ON (S.datid = D.oid)
         LEFT JOIN pg_authid AS U ON (S.usesysid = U.oid);
 
+CREATE VIEW pg_stat_memory_allocation AS
+    SELECT
+            S.datid AS datid,
+            D.datname AS datname,
+            S.pid,
+            S.backend_type,
+            M.allocated_bytes
+    FROM pg_stat_get_activity(NULL) AS S
+        JOIN pg_stat_get_memory_allocation() AS M ON (S.pid = M.pid)
+        LEFT JOIN pg_database AS D ON (S.datid = D.oid);
+
 CREATE VIEW pg_stat_replication AS
     SELECT
             S.pid,
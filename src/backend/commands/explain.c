@@ -80,6 +80,8 @@ static void show_upper_qual(List *qual, const char *qlabel,
 							ExplainState *es);
 static void show_sort_keys(SortState *sortstate, List *ancestors,
 						   ExplainState *es);
+static void show_incremental_sort_keys(IncrementalSortState *incrsortstate,
+									   List *ancestors, ExplainState *es);
 static void show_merge_append_keys(MergeAppendState *mstate, List *ancestors,
 								   ExplainState *es);
 static void show_agg_keys(AggState *astate, List *ancestors,
@@ -101,7 +103,12 @@ static void show_sortorder_options(StringInfo buf, Node *sortexpr,
 static void show_tablesample(TableSampleClause *tsc, PlanState *planstate,
 							 List *ancestors, ExplainState *es);
 static void show_sort_info(SortState *sortstate, ExplainState *es);
+static void show_incremental_sort_info(IncrementalSortState *incrsortstate,
+									   ExplainState *es);
 static void show_hash_info(HashState *hashstate, ExplainState *es);
+static void show_resultcache_info(ResultCacheState *rcstate, List *ancestors,
+								  ExplainState *es);
+static void show_hashagg_info(AggState *aggstate, ExplainState *es);
 static void show_tidbitmap_info(BitmapHeapScanState *planstate,
 								ExplainState *es);
 static void show_instrumentation_count(const char *qlabel, int which,
@@ -1209,9 +1216,15 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		case T_Material:
 			pname = sname = "Materialize";
 			break;
+		case T_ResultCache:
+			pname = sname = "Result Cache";
+			break;
 		case T_Sort:
 			pname = sname = "Sort";
 			break;
+		case T_IncrementalSort:
+			pname = sname = "Incremental Sort";
+			break;
 		case T_Group:
 			pname = sname = "Group";
 			break;
@@ -1827,6 +1840,8 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
+			if (es->analyze)
+				show_hashagg_info(castNode(AggState, planstate), es);
 			break;
 		case T_Group:
 			show_group_keys(castNode(GroupState, planstate), ancestors, es);
@@ -1839,10 +1854,20 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			show_sort_keys(castNode(SortState, planstate), ancestors, es);
 			show_sort_info(castNode(SortState, planstate), es);
 			break;
+		case T_IncrementalSort:
+			show_incremental_sort_keys(castNode(IncrementalSortState, planstate),
+									   ancestors, es);
+			show_incremental_sort_info(castNode(IncrementalSortState, planstate),
+									   es);
+			break;
 		case T_MergeAppend:
 			show_merge_append_keys(castNode(MergeAppendState, planstate),
 								   ancestors, es);
 			break;
+		case T_ResultCache:
+			show_resultcache_info(castNode(ResultCacheState, planstate),
+								  ancestors, es);
+			break;
 		case T_Result:
 			show_upper_qual((List *) ((Result *) plan)->resconstantqual,
 							"One-Time Filter", planstate, ancestors, es);
@@ -2198,6 +2223,27 @@ show_sort_keys(SortState *sortstate, List *ancestors, ExplainState *es)
 						 ancestors, es);
 }
 
+/*
+ * Show the sort keys for an IncrementalSort node, and which of them the
+ * input is already sorted by.
+ */
+static void
+show_incremental_sort_keys(IncrementalSortState *incrsortstate,
+						   List *ancestors, ExplainState *es)
+{
+	IncrementalSort *plan = (IncrementalSort *) incrsortstate->ss.ps.plan;
+
+	show_sort_group_keys((PlanState *) incrsortstate, "Sort Key",
+						 plan->sort.numCols, plan->sort.sortColIdx,
+						 plan->sort.sortOperators, plan->sort.collations,
+						 plan->sort.nullsFirst,
+						 ancestors, es);
+	show_sort_group_keys((PlanState *) incrsortstate, "Presorted Key",
+						 plan->nPresortedCols, plan->sort.sortColIdx,
+						 NULL, NULL, NULL,
+						 ancestors, es);
+}
+
 /*
  * Likewise, for a MergeAppend node.
  */
@@ -2629,6 +2675,105 @@ show_sort_info(SortState *sortstate, ExplainState *es)
 	}
 }
 
+/*
+ * If it's EXPLAIN ANALYZE, show the number of batches an IncrementalSort
+ * node sorted and the peak space used by any of them.
+ */
+static void
+show_incremental_sort_info(IncrementalSortState *incrsortstate,
+						   ExplainState *es)
+{
+	if (!es->analyze || incrsortstate->nbatches == 0)
+		return;
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str, "Sort Batches: " INT64_FORMAT "  Peak Memory: %ldkB",
+						 incrsortstate->nbatches,
+						 incrsortstate->max_memory_used);
+		if (incrsortstate->max_disk_used > 0)
+			appendStringInfo(es->str, "  Peak Disk: %ldkB",
+							 incrsortstate->max_disk_used);
+		appendStringInfoChar(es->str, '\n');
+	}
+	else
+	{
+		ExplainPropertyInteger("Sort Batches", NULL,
+							   incrsortstate->nbatches, es);
+		ExplainPropertyInteger("Peak Sort Memory Used", "kB",
+							   incrsortstate->max_memory_used, es);
+		ExplainPropertyInteger("Peak Sort Disk Used", "kB",
+							   incrsortstate->max_disk_used, es);
+	}
+}
+
+/*
+ * Show the cache keys of a ResultCache node and, if it's EXPLAIN ANALYZE,
+ * how well the cache worked.
+ */
+static void
+show_resultcache_info(ResultCacheState *rcstate, List *ancestors,
+					  ExplainState *es)
+{
+	ResultCache *plan = (ResultCache *) rcstate->ss.ps.plan;
+	List	   *context;
+	bool		useprefix;
+	StringInfoData keystr;
+	ListCell   *lc;
+
+	/* Set up deparsing context */
+	context = set_deparse_context_planstate(es->deparse_cxt,
+											(Node *) rcstate,
+											ancestors);
+	useprefix = list_length(es->rtable) > 1 || es->verbose;
+
+	initStringInfo(&keystr);
+	foreach(lc, plan->param_exprs)
+	{
+		Node	   *expr = (Node *) lfirst(lc);
+
+		if (keystr.len > 0)
+			appendStringInfoString(&keystr, ", ");
+		appendStringInfoString(&keystr,
+							   deparse_expression(expr, context,
+												  useprefix, false));
+	}
+	ExplainPropertyText("Cache Key", keystr.data, es);
+	pfree(keystr.data);
+
+	if (!es->analyze || rcstate->cache_hits + rcstate->cache_misses == 0)
+		return;
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str,
+						 "Hits: " UINT64_FORMAT "  Misses: " UINT64_FORMAT
+						 "  Evictions: " UINT64_FORMAT
+						 "  Overflows: " UINT64_FORMAT
+						 "  Memory Usage: " UINT64_FORMAT "kB\n",
+						 rcstate->cache_hits,
+						 rcstate->cache_misses,
+						 rcstate->cache_evictions,
+						 rcstate->cache_overflows,
+						 (rcstate->mem_peak + 1023) / 1024);
+	}
+	else
+	{
+		ExplainPropertyInteger("Cache Hits", NULL,
+							   rcstate->cache_hits, es);
+		ExplainPropertyInteger("Cache Misses", NULL,
+							   rcstate->cache_misses, es);
+		ExplainPropertyInteger("Cache Evictions", NULL,
+							   rcstate->cache_evictions, es);
+		ExplainPropertyInteger("Cache Overflows", NULL,
+							   rcstate->cache_overflows, es);
+		ExplainPropertyInteger("Peak Memory Usage", "kB",
+							   (rcstate->mem_peak + 1023) / 1024, es);
+	}
+}
+
 /*
  * Show information on hash buckets/batches.
  */
@@ -2732,6 +2877,35 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 	}
 }
 
+/*
+ * Show information on hashed aggregation that spilled to disk
+ */
+static void
+show_hashagg_info(AggState *aggstate, ExplainState *es)
+{
+	long		memPeakKb = (aggstate->hash_mem_peak + 1023) / 1024;
+
+	if (aggstate->hash_disk_used == 0)
+		return;
+
+	if (es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		ExplainPropertyInteger("HashAgg Batches", NULL,
+							   aggstate->hash_batches_used, es);
+		ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb, es);
+		ExplainPropertyInteger("Disk Usage", "kB",
+							   aggstate->hash_disk_used, es);
+	}
+	else
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str,
+						 "Batches: %d  Memory Usage: %ldkB  Disk Usage: " UINT64_FORMAT "kB\n",
+						 aggstate->hash_batches_used, memPeakKb,
+						 aggstate->hash_disk_used);
+	}
+}
+
 /*
  * If it's EXPLAIN ANALYZE, show exact/lossy pages for a BitmapHeapScan node
  */
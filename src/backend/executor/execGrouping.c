@@ -379,6 +379,31 @@ FindTupleHashEntry(TupleHashTable hashtable, TupleTableSlot *slot,
 	return entry;
 }
 
+/*
+ * Compute the hash value that LookupTupleHashEntry would compute for the
+ * given tuple, without searching the table.  This lets callers that have to
+ * set a tuple aside (e.g. to spill it to disk) partition it consistently
+ * with the table's own hashing.
+ */
+uint32
+TupleHashTableHashSlot(TupleHashTable hashtable, TupleTableSlot *slot)
+{
+	MemoryContext oldContext;
+	uint32		hash;
+
+	/* Need to run the hash functions in short-lived context */
+	oldContext = MemoryContextSwitchTo(hashtable->tempcxt);
+
+	hashtable->inputslot = slot;
+	hashtable->in_hash_funcs = hashtable->tab_hash_funcs;
+
+	hash = TupleHashTableHash(hashtable->hashtab, NULL);
+
+	MemoryContextSwitchTo(oldContext);
+
+	return hash;
+}
+
 /*
  * Compute the hash value for a tuple
  *
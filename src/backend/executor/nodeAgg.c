@@ -194,6 +194,20 @@
  *	  transition values.  hashcontext is the single context created to support
  *	  all hash tables.
  *
+ *	  Spilling hashed aggregation to disk:
+ *
+ *	  When there is a single hashed grouping set (plain AGG_HASHED without
+ *	  grouping sets), the hash table is not allowed to grow much past
+ *	  work_mem.  Once it does, no new groups are created; input tuples that
+ *	  belong to a group already in the table are still aggregated, the others
+ *	  are written out to one of several temporary files, partitioned by the
+ *	  hash value bits following those already used by earlier passes.  After
+ *	  the groups of the table have been emitted, the table is emptied and
+ *	  each partition is read back as a new batch of input, which may spill
+ *	  again itself.  Every group thus ends up completely within one batch.
+ *	  Memory usage is checked at geometrically growing intervals of the
+ *	  number of groups, as measuring it walks the contexts' blocks.
+ *
  *    Transition / Combine function invocation:
  *
  *    For performance reasons transition functions, including combine
@@ -230,14 +244,50 @@
 #include "optimizer/optimizer.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
+#include "storage/buffile.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/dynahash.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/syscache.h"
 #include "utils/tuplesort.h"
 #include "utils/datum.h"
 
+/*
+ * Limits on the number of partitions a spilling pass of hashed aggregation
+ * writes, and the minimum number of new groups between memory checks.
+ */
+#define HASHAGG_MIN_PARTITIONS 4
+#define HASHAGG_MIN_PARTITION_BITS 2
+#define HASHAGG_MAX_PARTITIONS 256
+#define HASHAGG_CHECK_INTERVAL 32
+
+/*
+ * Spill files written during one pass over hashed input.  A tuple whose
+ * group is not in the hash table goes to the partition selected by the
+ * partition_bits hash bits following the ones used by previous passes.
+ */
+typedef struct HashAggSpill
+{
+	int			npartitions;	/* number of spill files */
+	int			partition_bits; /* log2(npartitions) */
+	BufFile   **partitions;		/* spill files, created on first use */
+	int64	   *ntuples;		/* number of tuples in each file */
+	uint64	   *nbytes;			/* number of bytes in each file */
+	uint32		mask;			/* hash bits that select the partition */
+	int			shift;			/* position of the lowest of those bits */
+} HashAggSpill;
+
+/*
+ * A spilled partition, to be aggregated by a later pass.
+ */
+typedef struct HashAggBatch
+{
+	int			used_bits;		/* hash bits that partitioned this batch */
+	BufFile    *input_file;		/* spilled tuples, rewound */
+	int64		input_tuples;	/* number of tuples in input_file */
+} HashAggBatch;
 
 static void select_current_set(AggState *aggstate, int setno, bool is_hash);
 static void initialize_phase(AggState *aggstate, int newphase);
@@ -275,6 +325,16 @@ static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void build_hash_table(AggState *aggstate);
 static TupleHashEntryData *lookup_hash_entry(AggState *aggstate);
 static void lookup_hash_entries(AggState *aggstate);
+static Size hash_agg_mem_usage(AggState *aggstate);
+static void hash_agg_check_limits(AggState *aggstate);
+static void hash_agg_spill_init(AggState *aggstate, double input_groups);
+static void hash_agg_spill_tuple(AggState *aggstate, TupleTableSlot *slot,
+								 uint32 hash, double input_groups);
+static MinimalTuple hash_agg_read_spilled(AggState *aggstate, BufFile *file,
+										  uint32 *hash);
+static void hash_agg_finish_spill(AggState *aggstate);
+static void hash_agg_discard_batches(AggState *aggstate);
+static bool agg_refill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static void agg_fill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
@@ -1451,6 +1511,10 @@ hash_agg_entry_size(int numAggs)
  * set (which the caller must have selected - note that initialize_aggregate
  * depends on this).
  *
+ * If the hash table has been filled up to its memory limit, no new entries
+ * are created, and NULL is returned if the tuple's group is not present; the
+ * caller has to spill the tuple.
+ *
  * When called, CurrentMemoryContext should be the per-query context.
  */
 static TupleHashEntryData *
@@ -1476,6 +1540,10 @@ lookup_hash_entry(AggState *aggstate)
 	}
 	ExecStoreVirtualTuple(hashslot);
 
+	/* in spill mode, only look for an existing entry */
+	if (aggstate->hash_spill_mode)
+		return LookupTupleHashEntry(perhash->hashtable, hashslot, NULL);
+
 	/* find or create the hashtable entry using the filtered tuple */
 	entry = LookupTupleHashEntry(perhash->hashtable, hashslot, &isnew);
 
@@ -1500,6 +1568,9 @@ lookup_hash_entry(AggState *aggstate)
 
 			initialize_aggregate(aggstate, pertrans, pergroupstate);
 		}
+
+		aggstate->hash_ngroups_current++;
+		hash_agg_check_limits(aggstate);
 	}
 
 	return entry;
@@ -1508,6 +1579,8 @@ lookup_hash_entry(AggState *aggstate)
 /*
  * Look up hash entries for the current tuple in all hashed grouping sets,
  * returning an array of pergroup pointers suitable for advance_aggregates.
+ * A pointer is NULL if the tuple has to be spilled instead (which can only
+ * happen with a single hashed grouping set).
  *
  * Be aware that lookup_hash_entry can reset the tmpcontext.
  */
@@ -1520,9 +1593,300 @@ lookup_hash_entries(AggState *aggstate)
 
 	for (setno = 0; setno < numHashes; setno++)
 	{
+		TupleHashEntryData *entry;
+
 		select_current_set(aggstate, setno, true);
-		pergroup[setno] = lookup_hash_entry(aggstate)->additional;
+		entry = lookup_hash_entry(aggstate);
+		pergroup[setno] = entry ? entry->additional : NULL;
+	}
+}
+
+/*
+ * Compute the memory used by the hash table: its bucket array, plus the
+ * hashcontext, which holds the groups' representative tuples and transition
+ * values.
+ */
+static Size
+hash_agg_mem_usage(AggState *aggstate)
+{
+	TupleHashTable hashtable = aggstate->perhash[0].hashtable;
+	MemoryContextCounters counters;
+	List	   *pending;
+
+	memset(&counters, 0, sizeof(counters));
+
+	/* sum the stats of the context tree, without printing them */
+	pending = list_make1(aggstate->hashcontext->ecxt_per_tuple_memory);
+	while (pending != NIL)
+	{
+		MemoryContext context = (MemoryContext) linitial(pending);
+		MemoryContext child;
+
+		pending = list_delete_first(pending);
+		context->methods->stats(context, NULL, NULL, &counters);
+		for (child = context->firstchild; child != NULL; child = child->nextchild)
+			pending = lappend(pending, child);
 	}
+
+	return counters.totalspace +
+		hashtable->hashtab->size * sizeof(TupleHashEntryData);
+}
+
+/*
+ * Called after a new group has been added to the hash table.  Once the table
+ * exceeds its memory limit, switch to spill mode for the rest of this pass.
+ */
+static void
+hash_agg_check_limits(AggState *aggstate)
+{
+	uint64		ngroups = aggstate->hash_ngroups_current;
+	Size		mem_used;
+
+	if (!aggstate->hash_spill_allowed || aggstate->hash_spill_mode ||
+		ngroups < aggstate->hash_next_check)
+		return;
+
+	aggstate->hash_next_check = ngroups + Max(HASHAGG_CHECK_INTERVAL,
+											  ngroups / 16);
+
+	mem_used = hash_agg_mem_usage(aggstate);
+	aggstate->hash_mem_peak = Max(aggstate->hash_mem_peak, mem_used);
+
+	/*
+	 * Without enough unused hash bits left to partition the input further,
+	 * just keep growing the table; we'd only spill everything again.
+	 */
+	if (mem_used > aggstate->hash_mem_limit &&
+		aggstate->hash_used_bits + HASHAGG_MIN_PARTITION_BITS <= 32)
+		aggstate->hash_spill_mode = true;
+}
+
+/*
+ * Set up the spill files for the current pass.  input_groups is the
+ * estimated number of groups in the pass's input.
+ */
+static void
+hash_agg_spill_init(AggState *aggstate, double input_groups)
+{
+	HashAggSpill *spill;
+	double		ngroups = Max(aggstate->hash_ngroups_current, 1);
+	double		group_size;
+	double		dpartitions;
+	int			partition_bits;
+	MemoryContext oldcontext;
+
+	/*
+	 * The groups that didn't fit must be spread over enough partitions that
+	 * each of those fits into memory.  If the estimate proved too low, assume
+	 * at least as many groups again as are in the table already.  Don't let
+	 * the partitions' buffers take more than a quarter of work_mem, though.
+	 */
+	group_size = hash_agg_mem_usage(aggstate) / ngroups;
+	input_groups = Max(input_groups - ngroups, ngroups);
+	dpartitions = 1 + input_groups * group_size / aggstate->hash_mem_limit;
+	dpartitions = Min(dpartitions, aggstate->hash_mem_limit / 4 / BLCKSZ);
+	dpartitions = Max(dpartitions, HASHAGG_MIN_PARTITIONS);
+	dpartitions = Min(dpartitions, HASHAGG_MAX_PARTITIONS);
+
+	partition_bits = my_log2((long) dpartitions);
+	if (aggstate->hash_used_bits + partition_bits > 32)
+		partition_bits = 32 - aggstate->hash_used_bits;
+
+	oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+
+	spill = (HashAggSpill *) palloc(sizeof(HashAggSpill));
+	spill->partition_bits = partition_bits;
+	spill->npartitions = 1 << partition_bits;
+	spill->partitions = (BufFile **) palloc0(sizeof(BufFile *) * spill->npartitions);
+	spill->ntuples = (int64 *) palloc0(sizeof(int64) * spill->npartitions);
+	spill->nbytes = (uint64 *) palloc0(sizeof(uint64) * spill->npartitions);
+	spill->shift = 32 - aggstate->hash_used_bits - partition_bits;
+	spill->mask = (uint32) (spill->npartitions - 1) << spill->shift;
+
+	aggstate->hash_spill = spill;
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Write a tuple whose group is not in the hash table to its partition's
+ * spill file.  The format is the same as for hash join batch files: the hash
+ * value, followed by the tuple in MinimalTuple format.
+ */
+static void
+hash_agg_spill_tuple(AggState *aggstate, TupleTableSlot *slot, uint32 hash,
+					 double input_groups)
+{
+	HashAggSpill *spill;
+	int			partition;
+	BufFile    *file;
+	MinimalTuple tuple;
+	bool		shouldFree;
+
+	if (aggstate->hash_spill == NULL)
+		hash_agg_spill_init(aggstate, input_groups);
+	spill = aggstate->hash_spill;
+
+	partition = (hash & spill->mask) >> spill->shift;
+	file = spill->partitions[partition];
+	if (file == NULL)
+	{
+		MemoryContext oldcontext;
+
+		oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+		file = spill->partitions[partition] = BufFileCreateTemp(false);
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+	BufFileWrite(file, (void *) &hash, sizeof(uint32));
+	BufFileWrite(file, (void *) tuple, tuple->t_len);
+
+	spill->ntuples[partition]++;
+	spill->nbytes[partition] += sizeof(uint32) + tuple->t_len;
+
+	if (shouldFree)
+		pfree(tuple);
+}
+
+/*
+ * Read the next tuple from a spill file.  Returns NULL at end of file.
+ *
+ * The tuple lives in a buffer that is reused by the next call.
+ */
+static MinimalTuple
+hash_agg_read_spilled(AggState *aggstate, BufFile *file, uint32 *hash)
+{
+	uint32		header[2];
+	size_t		nread;
+	MinimalTuple tuple;
+
+	/*
+	 * Since both the hash value and the MinimalTuple length word are uint32,
+	 * we can read them both in one BufFileRead() call.
+	 */
+	nread = BufFileRead(file, (void *) header, sizeof(header));
+	if (nread == 0)				/* end of file */
+		return NULL;
+	if (nread != sizeof(header))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash aggregate temporary file: read only %zu of %zu bytes",
+						nread, sizeof(header))));
+	*hash = header[0];
+
+	if (header[1] > aggstate->hash_spill_buflen)
+	{
+		Size		newlen = Max(header[1], 2 * aggstate->hash_spill_buflen);
+
+		if (aggstate->hash_spill_buf == NULL)
+			aggstate->hash_spill_buf =
+				MemoryContextAlloc(aggstate->ss.ps.state->es_query_cxt, newlen);
+		else
+			aggstate->hash_spill_buf = repalloc(aggstate->hash_spill_buf, newlen);
+		aggstate->hash_spill_buflen = newlen;
+	}
+
+	tuple = (MinimalTuple) aggstate->hash_spill_buf;
+	tuple->t_len = header[1];
+	nread = BufFileRead(file,
+						(void *) ((char *) tuple + sizeof(uint32)),
+						header[1] - sizeof(uint32));
+	if (nread != header[1] - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash aggregate temporary file: read only %zu of %zu bytes",
+						nread, header[1] - sizeof(uint32))));
+
+	return tuple;
+}
+
+/*
+ * At the end of a pass over hashed input, turn the partitions that the pass
+ * spilled into batches to be processed later.
+ */
+static void
+hash_agg_finish_spill(AggState *aggstate)
+{
+	HashAggSpill *spill = aggstate->hash_spill;
+	MemoryContext oldcontext;
+	int			i;
+
+	aggstate->hash_batches_used++;
+	if (aggstate->hash_spill_allowed)
+		aggstate->hash_mem_peak = Max(aggstate->hash_mem_peak,
+									  hash_agg_mem_usage(aggstate));
+
+	if (spill == NULL)
+		return;
+
+	oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+
+	for (i = 0; i < spill->npartitions; i++)
+	{
+		BufFile    *file = spill->partitions[i];
+		HashAggBatch *batch;
+
+		if (file == NULL)
+			continue;
+
+		if (BufFileSeek(file, 0, 0L, SEEK_SET))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not rewind hash aggregate temporary file")));
+
+		batch = (HashAggBatch *) palloc(sizeof(HashAggBatch));
+		batch->used_bits = aggstate->hash_used_bits + spill->partition_bits;
+		batch->input_file = file;
+		batch->input_tuples = spill->ntuples[i];
+		aggstate->hash_batches = lappend(aggstate->hash_batches, batch);
+
+		aggstate->hash_disk_used += (spill->nbytes[i] + 1023) / 1024;
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	pfree(spill->partitions);
+	pfree(spill->ntuples);
+	pfree(spill->nbytes);
+	pfree(spill);
+	aggstate->hash_spill = NULL;
+}
+
+/*
+ * Close the spill files of all batches that haven't been processed yet.
+ */
+static void
+hash_agg_discard_batches(AggState *aggstate)
+{
+	ListCell   *lc;
+
+	if (aggstate->hash_spill != NULL)
+	{
+		HashAggSpill *spill = aggstate->hash_spill;
+		int			i;
+
+		for (i = 0; i < spill->npartitions; i++)
+		{
+			if (spill->partitions[i] != NULL)
+				BufFileClose(spill->partitions[i]);
+		}
+		pfree(spill->partitions);
+		pfree(spill->ntuples);
+		pfree(spill->nbytes);
+		pfree(spill);
+		aggstate->hash_spill = NULL;
+	}
+
+	foreach(lc, aggstate->hash_batches)
+	{
+		HashAggBatch *batch = (HashAggBatch *) lfirst(lc);
+
+		BufFileClose(batch->input_file);
+		pfree(batch);
+	}
+	list_free(aggstate->hash_batches);
+	aggstate->hash_batches = NIL;
 }
 
 /*
@@ -1936,8 +2300,21 @@ agg_fill_hash_table(AggState *aggstate)
 		/* Find or build hashtable entries */
 		lookup_hash_entries(aggstate);
 
-		/* Advance the aggregates (or combine functions) */
-		advance_aggregates(aggstate);
+		/*
+		 * Advance the aggregates (or combine functions), unless the tuple's
+		 * group didn't fit into the hash table; set the tuple aside then.
+		 */
+		if (aggstate->hash_pergroup[0] != NULL)
+			advance_aggregates(aggstate);
+		else
+		{
+			AggStatePerHash perhash = &aggstate->perhash[0];
+
+			hash_agg_spill_tuple(aggstate, outerslot,
+								 TupleHashTableHashSlot(perhash->hashtable,
+														perhash->hashslot),
+								 perhash->aggnode->numGroups);
+		}
 
 		/*
 		 * Reset per-input-tuple context after each tuple, but note that the
@@ -1946,6 +2323,8 @@ agg_fill_hash_table(AggState *aggstate)
 		ResetExprContext(aggstate->tmpcontext);
 	}
 
+	hash_agg_finish_spill(aggstate);
+
 	aggstate->table_filled = true;
 	/* Initialize to walk the first hash table */
 	select_current_set(aggstate, 0, true);
@@ -1953,6 +2332,73 @@ agg_fill_hash_table(AggState *aggstate)
 						   &aggstate->perhash[0].hashiter);
 }
 
+/*
+ * ExecAgg for hashed case: once all groups of the hash table have been
+ * returned, rebuild the table from the next batch of spilled tuples.
+ * Returns false if there are no batches left.
+ */
+static bool
+agg_refill_hash_table(AggState *aggstate)
+{
+	HashAggBatch *batch;
+	TupleTableSlot *slot = aggstate->hash_spill_slot;
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	MinimalTuple tuple;
+	uint32		hash;
+
+	if (aggstate->hash_batches == NIL)
+		return false;
+
+	batch = (HashAggBatch *) linitial(aggstate->hash_batches);
+	aggstate->hash_batches = list_delete_first(aggstate->hash_batches);
+
+	/*
+	 * All groups in the table have been returned, so free them and start
+	 * over with an empty table.  (We use rescan rather than just reset
+	 * because transfns may have registered callbacks that need to be run
+	 * now.)
+	 */
+	ReScanExprContext(aggstate->hashcontext);
+	build_hash_table(aggstate);
+	aggstate->hash_spill_mode = false;
+	aggstate->hash_ngroups_current = 0;
+	aggstate->hash_next_check = HASHAGG_CHECK_INTERVAL;
+	aggstate->hash_used_bits = batch->used_bits;
+
+	while ((tuple = hash_agg_read_spilled(aggstate, batch->input_file,
+										  &hash)) != NULL)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		ExecForceStoreMinimalTuple(tuple, slot, false);
+
+		/* set up for lookup_hash_entries and advance_aggregates */
+		tmpcontext->ecxt_outertuple = slot;
+
+		lookup_hash_entries(aggstate);
+
+		if (aggstate->hash_pergroup[0] != NULL)
+			advance_aggregates(aggstate);
+		else
+			hash_agg_spill_tuple(aggstate, slot, hash,
+								 (double) batch->input_tuples);
+
+		ResetExprContext(aggstate->tmpcontext);
+	}
+
+	BufFileClose(batch->input_file);
+	pfree(batch);
+
+	hash_agg_finish_spill(aggstate);
+
+	/* Initialize to walk the hash table */
+	select_current_set(aggstate, 0, true);
+	ResetTupleHashIterator(aggstate->perhash[0].hashtable,
+						   &aggstate->perhash[0].hashiter);
+
+	return true;
+}
+
 /*
  * ExecAgg for hashed case: retrieving groups from hash table
  */
@@ -2015,6 +2461,13 @@ agg_retrieve_hash_table(AggState *aggstate)
 
 				continue;
 			}
+			else if (agg_refill_hash_table(aggstate))
+			{
+				/* Continue with the groups of the next spilled batch */
+				perhash = &aggstate->perhash[aggstate->current_set];
+
+				continue;
+			}
 			else
 			{
 				/* No more hashtables, so done */
@@ -2259,6 +2712,22 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 			aggstate->ss.ps.outeropsfixed = false;
 	}
 
+	/*
+	 * A single hashed grouping set can spill to disk; spilled tuples are read
+	 * back into a slot of their own, with the same consequences as above.
+	 */
+	if (node->aggstrategy == AGG_HASHED && numHashes == 1)
+	{
+		aggstate->hash_spill_allowed = true;
+		aggstate->hash_mem_limit = work_mem * 1024L;
+		aggstate->hash_next_check = HASHAGG_CHECK_INTERVAL;
+		aggstate->hash_spill_slot = ExecInitExtraTupleSlot(estate, scanDesc,
+														   &TTSOpsMinimalTuple);
+		if (aggstate->ss.ps.outeropsfixed &&
+			aggstate->ss.ps.outerops != &TTSOpsMinimalTuple)
+			aggstate->ss.ps.outeropsfixed = false;
+	}
+
 	/*
 	 * Initialize result type, slot and projection.
 	 */
@@ -3386,12 +3855,13 @@ ExecEndAgg(AggState *node)
 	int			numGroupingSets = Max(node->maxsets, 1);
 	int			setno;
 
-	/* Make sure we have closed any open tuplesorts */
+	/* Make sure we have closed any open tuplesorts and spill files */
 
 	if (node->sort_in)
 		tuplesort_end(node->sort_in);
 	if (node->sort_out)
 		tuplesort_end(node->sort_out);
+	hash_agg_discard_batches(node);
 
 	for (transno = 0; transno < node->numtrans; transno++)
 	{
@@ -3451,10 +3921,13 @@ ExecReScanAgg(AggState *node)
 		 * If we do have the hash table, and the subplan does not have any
 		 * parameter changes, and none of our own parameter changes affect
 		 * input expressions of the aggregated functions, then we can just
-		 * rescan the existing hash table; no need to build it again.
+		 * rescan the existing hash table; no need to build it again.  That
+		 * doesn't work if any input was spilled, as the table then holds
+		 * only part of the groups.
 		 */
 		if (outerPlan->chgParam == NULL &&
-			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
+			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams) &&
+			node->hash_disk_used == 0)
 		{
 			ResetTupleHashIterator(node->perhash[0].hashtable,
 								   &node->perhash[0].hashiter);
@@ -3514,6 +3987,12 @@ ExecReScanAgg(AggState *node)
 		/* Rebuild an empty hash table */
 		build_hash_table(node);
 		node->table_filled = false;
+		/* Forget about any spilled input */
+		hash_agg_discard_batches(node);
+		node->hash_spill_mode = false;
+		node->hash_ngroups_current = 0;
+		node->hash_next_check = HASHAGG_CHECK_INTERVAL;
+		node->hash_used_bits = 0;
 		/* iterator will be reset when the table is filled */
 	}
 
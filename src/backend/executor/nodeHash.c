@@ -44,6 +44,9 @@
 #include "utils/syscache.h"
 
 
+/* # of tuples whose bucket heads we prefetch at once when rebuilding */
+#define HASH_REBUILD_PREFETCH	16
+
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecHashIncreaseNumBuckets(HashJoinTable hashtable);
 static void ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable);
@@ -80,6 +83,7 @@ static bool ExecParallelHashTuplePrealloc(HashJoinTable hashtable,
 										  size_t size);
 static void ExecParallelHashMergeCounters(HashJoinTable hashtable);
 static void ExecParallelHashCloseBatchAccessors(HashJoinTable hashtable);
+static void ExecHashCreateBloomFilter(HashJoinTable hashtable);
 
 
 /* ----------------------------------------------------------------
@@ -157,6 +161,14 @@ MultiExecPrivateHash(HashState *node)
 	hashkeys = node->hashkeys;
 	econtext = node->ps.ps_ExprContext;
 
+	/*
+	 * If we already know we'll need more than one batch, start collecting
+	 * hash values into the bloom filter right away.  Otherwise it's created
+	 * by ExecHashIncreaseNumBatches, if we ever get there.
+	 */
+	if (hashtable->useBloomFilter && hashtable->nbatch > 1)
+		ExecHashCreateBloomFilter(hashtable);
+
 	/*
 	 * Get all tuples from the node below the Hash node and insert into the
 	 * hash table (or temp files).
@@ -187,6 +199,10 @@ MultiExecPrivateHash(HashState *node)
 				/* Not subject to skew optimization, so insert normally */
 				ExecHashTableInsert(hashtable, slot, hashvalue);
 			}
+			if (hashtable->bloomFilter)
+				bloom_add_element(hashtable->bloomFilter,
+								  (unsigned char *) &hashvalue,
+								  sizeof(hashvalue));
 			hashtable->totalTuples += 1;
 		}
 	}
@@ -502,6 +518,9 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->skewTuples = 0;
 	hashtable->innerBatchFile = NULL;
 	hashtable->outerBatchFile = NULL;
+	hashtable->useBloomFilter = false;
+	hashtable->innerRows = rows;
+	hashtable->bloomFilter = NULL;
 	hashtable->spaceUsed = 0;
 	hashtable->spacePeak = 0;
 	hashtable->spaceAllowed = space_allowed;
@@ -940,6 +959,14 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 
 	hashtable->nbatch = nbatch;
 
+	/*
+	 * If we're going multi-batch for the first time, create the bloom filter
+	 * now.  Every inner tuple seen so far is still in memory, so the scan
+	 * below can add their hash values to it.
+	 */
+	if (hashtable->useBloomFilter && hashtable->bloomFilter == NULL)
+		ExecHashCreateBloomFilter(hashtable);
+
 	/*
 	 * Scan through the existing hash table entries and dump out any that are
 	 * no longer of the current batch.
@@ -991,6 +1018,11 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 			ExecHashGetBucketAndBatch(hashtable, hashTuple->hashvalue,
 									  &bucketno, &batchno);
 
+			if (oldnbatch == 1 && hashtable->bloomFilter)
+				bloom_add_element(hashtable->bloomFilter,
+								  (unsigned char *) &hashTuple->hashvalue,
+								  sizeof(hashTuple->hashvalue));
+
 			if (batchno == curbatch)
 			{
 				/* keep tuple in memory - copy it into the new chunk */
@@ -1424,6 +1456,53 @@ ExecParallelHashMergeCounters(HashJoinTable hashtable)
 	LWLockRelease(&pstate->lock);
 }
 
+/*
+ * ExecHashCreateBloomFilter
+ *		create the bloom filter used to discard outer tuples that can't
+ *		have a match in a later batch
+ *
+ * The filter lives in hashCxt, so it goes away along with the hash table.
+ * Its memory is charged to spaceUsed until ExecHashTableReset frees it.
+ */
+static void
+ExecHashCreateBloomFilter(HashJoinTable hashtable)
+{
+	MemoryContext oldcxt;
+	double		nelems;
+	Size		bloom_bytes;
+
+	Assert(hashtable->parallel_state == NULL);
+	Assert(hashtable->bloomFilter == NULL);
+
+	/*
+	 * Give the filter a share of the join's memory budget.  If that's too
+	 * little for the smallest filter bloom_create() makes, do without.
+	 */
+	bloom_bytes = hashtable->spaceAllowed * BLOOM_WORK_MEM_PERCENT / 100;
+	if (bloom_bytes < 1024 * 1024)
+	{
+		hashtable->useBloomFilter = false;
+		return;
+	}
+
+	/*
+	 * If we're only getting here because the planner's estimate was too
+	 * low, assume the inner side is at least twice as large as what we've
+	 * seen so far.
+	 */
+	nelems = Max(hashtable->innerRows, hashtable->totalTuples * 2);
+	nelems = Max(nelems, 1);
+
+	oldcxt = MemoryContextSwitchTo(hashtable->hashCxt);
+	hashtable->bloomFilter = bloom_create((int64) nelems,
+										  (int) (bloom_bytes / 1024), 0);
+	MemoryContextSwitchTo(oldcxt);
+
+	hashtable->spaceUsed += GetMemoryChunkSpace(hashtable->bloomFilter);
+	if (hashtable->spaceUsed > hashtable->spacePeak)
+		hashtable->spacePeak = hashtable->spaceUsed;
+}
+
 /*
  * ExecHashIncreaseNumBuckets
  *		increase the original number of buckets in order to reduce
@@ -1463,7 +1542,14 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 	memset(hashtable->buckets.unshared, 0,
 		   hashtable->nbuckets * sizeof(HashJoinTuple));
 
-	/* scan through all tuples in all chunks to rebuild the hash table */
+	/*
+	 * Scan through all tuples in all chunks to rebuild the hash table.  The
+	 * tuples are read sequentially, but the bucket heads they're linked into
+	 * are effectively random, so with a large bucket array nearly every
+	 * insertion misses the cache.  To overlap those misses, we work in
+	 * groups of HASH_REBUILD_PREFETCH tuples: first compute the bucket of
+	 * each and prefetch its head, then link the whole group in.
+	 */
 	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
 	{
 		/* process all tuples stored in this chunk */
@@ -1471,20 +1557,32 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 
 		while (idx < chunk->used)
 		{
-			HashJoinTuple hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
-			int			bucketno;
-			int			batchno;
+			HashJoinTuple tuples[HASH_REBUILD_PREFETCH];
+			int			bucketnos[HASH_REBUILD_PREFETCH];
+			int			ntuples = 0;
+			int			i;
 
-			ExecHashGetBucketAndBatch(hashtable, hashTuple->hashvalue,
-									  &bucketno, &batchno);
+			while (idx < chunk->used && ntuples < HASH_REBUILD_PREFETCH)
+			{
+				HashJoinTuple hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
+				int			batchno;
 
-			/* add the tuple to the proper bucket */
-			hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
-			hashtable->buckets.unshared[bucketno] = hashTuple;
+				ExecHashGetBucketAndBatch(hashtable, hashTuple->hashvalue,
+										  &bucketnos[ntuples], &batchno);
+				pg_prefetch_mem(&hashtable->buckets.unshared[bucketnos[ntuples]]);
+				tuples[ntuples++] = hashTuple;
 
-			/* advance index past the tuple */
-			idx += MAXALIGN(HJTUPLE_OVERHEAD +
-							HJTUPLE_MINTUPLE(hashTuple)->t_len);
+				/* advance index past the tuple */
+				idx += MAXALIGN(HJTUPLE_OVERHEAD +
+								HJTUPLE_MINTUPLE(hashTuple)->t_len);
+			}
+
+			/* add the tuples to the proper buckets */
+			for (i = 0; i < ntuples; i++)
+			{
+				tuples[i]->next.unshared = hashtable->buckets.unshared[bucketnos[i]];
+				hashtable->buckets.unshared[bucketnos[i]] = tuples[i];
+			}
 		}
 
 		/* allow this loop to be cancellable */
@@ -1954,6 +2052,12 @@ ExecScanHashBucket(HashJoinState *hjstate,
 
 	while (hashTuple != NULL)
 	{
+		/*
+		 * Start fetching the next tuple in the chain while we look at this
+		 * one; for large hash tables every step is likely a cache miss.
+		 */
+		pg_prefetch_mem(hashTuple->next.unshared);
+
 		if (hashTuple->hashvalue == hashvalue)
 		{
 			TupleTableSlot *inntuple;
@@ -2011,6 +2115,11 @@ ExecParallelScanHashBucket(HashJoinState *hjstate,
 
 	while (hashTuple != NULL)
 	{
+		HashJoinTuple nextTuple = ExecParallelHashNextTuple(hashtable, hashTuple);
+
+		/* as in ExecScanHashBucket, overlap the next chain step's miss */
+		pg_prefetch_mem(nextTuple);
+
 		if (hashTuple->hashvalue == hashvalue)
 		{
 			TupleTableSlot *inntuple;
@@ -2028,7 +2137,7 @@ ExecParallelScanHashBucket(HashJoinState *hjstate,
 			}
 		}
 
-		hashTuple = ExecParallelHashNextTuple(hashtable, hashTuple);
+		hashTuple = nextTuple;
 	}
 
 	/*
@@ -2159,6 +2268,19 @@ ExecHashTableReset(HashJoinTable hashtable)
 
 	/* Forget the chunks (the memory was freed by the context reset above). */
 	hashtable->chunks = NULL;
+
+	/*
+	 * The bloom filter only saves work while outer tuples are being assigned
+	 * to batches, which is mostly done during the first batch.  Release its
+	 * memory for the tuples of the later ones.  It must not be rebuilt if
+	 * nbatch grows again, since most inner tuples are no longer in memory.
+	 */
+	if (hashtable->bloomFilter)
+	{
+		bloom_free(hashtable->bloomFilter);
+		hashtable->bloomFilter = NULL;
+	}
+	hashtable->useBloomFilter = false;
 }
 
 /*
@@ -282,6 +282,16 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 												HJ_FILL_INNER(node));
 				node->hj_HashTable = hashtable;
 
+				/*
+				 * Unless we have to emit unmatched outer tuples, a batched
+				 * join can discard outer tuples whose hash value never
+				 * appeared on the inner side, rather than spooling them to
+				 * disk.  Parallel Hash shares its batches between
+				 * participants, so it doesn't use a private filter.
+				 */
+				hashtable->useBloomFilter = !HJ_FILL_OUTER(node) &&
+					hashtable->parallel_state == NULL;
+
 				/*
 				 * Execute the Hash node, to build the hash table.  If using
 				 * Parallel Hash, then we'll try to help hashing unless we
@@ -391,15 +401,27 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 					node->hj_CurSkewBucketNo == INVALID_SKEW_BUCKET_NO)
 				{
 					bool		shouldFree;
-					MinimalTuple mintuple = ExecFetchSlotMinimalTuple(outerTupleSlot,
-																	  &shouldFree);
+					MinimalTuple mintuple;
+
+					Assert(parallel_state == NULL);
+					Assert(batchno > hashtable->curbatch);
+
+					/*
+					 * If no inner tuple has this hash value, the outer tuple
+					 * can't join to anything, so don't bother saving it.
+					 */
+					if (hashtable->bloomFilter &&
+						bloom_lacks_element(hashtable->bloomFilter,
+											(unsigned char *) &hashvalue,
+											sizeof(hashvalue)))
+						continue;
 
 					/*
 					 * Need to postpone this outer tuple to a later batch.
 					 * Save it in the corresponding outer-batch file.
 					 */
-					Assert(parallel_state == NULL);
-					Assert(batchno > hashtable->curbatch);
+					mintuple = ExecFetchSlotMinimalTuple(outerTupleSlot,
+														 &shouldFree);
 					ExecHashJoinSaveTuple(mintuple, hashvalue,
 										  &hashtable->outerBatchFile[batchno]);
 
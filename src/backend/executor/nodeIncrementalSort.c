@@ -0,0 +1,347 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeIncrementalSort.c
+ *	  Routines to handle incremental sorting of relations.
+ *
+ * Incremental sort is used when the input is already sorted by a prefix of
+ * the requested sort keys, for example (a) when (a, b) is required.  Only
+ * tuples that agree on the presorted columns need to be sorted among
+ * themselves, so the input is cut into batches at changes of the presorted
+ * columns, and each batch is sorted on its own.  This way the first output
+ * tuples are available after reading just the first groups of the input,
+ * which helps a lot below a LIMIT, and each sort is much smaller.
+ *
+ * Sorting every small group separately would be slow, so a batch always
+ * takes at least INCREMENTALSORT_MIN_BATCH tuples, possibly spanning several
+ * groups, and then continues up to the end of the group of its last tuple.
+ * The whole batch is sorted on all the sort keys.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeIncrementalSort.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "executor/execdebug.h"
+#include "executor/nodeIncrementalSort.h"
+#include "miscadmin.h"
+#include "utils/lsyscache.h"
+#include "utils/tuplesort.h"
+
+/* minimum number of tuples sorted together */
+#define INCREMENTALSORT_MIN_BATCH 32
+
+
+/*
+ * Release the tuplesort of the current batch, remembering its space usage
+ * for EXPLAIN ANALYZE.
+ */
+static void
+finish_batch(IncrementalSortState *node)
+{
+	Tuplesortstate *tuplesortstate = (Tuplesortstate *) node->tuplesortstate;
+	TuplesortInstrumentation stats;
+
+	if (tuplesortstate == NULL)
+		return;
+
+	tuplesort_get_stats(tuplesortstate, &stats);
+	if (stats.spaceType == SORT_SPACE_TYPE_DISK)
+		node->max_disk_used = Max(node->max_disk_used, stats.spaceUsed);
+	else
+		node->max_memory_used = Max(node->max_memory_used, stats.spaceUsed);
+
+	tuplesort_end(tuplesortstate);
+	node->tuplesortstate = NULL;
+	node->batch_sorted = false;
+}
+
+/*
+ * Read the next batch of input tuples and sort it.  Returns false if the
+ * input is exhausted.
+ */
+static bool
+load_next_batch(IncrementalSortState *node)
+{
+	IncrementalSort *plannode = (IncrementalSort *) node->ss.ps.plan;
+	PlanState  *outerNode = outerPlanState(node);
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	Tuplesortstate *tuplesortstate;
+	int64		ntuples = 0;
+
+	if (node->outer_done)
+		return false;
+
+	tuplesortstate = tuplesort_begin_heap(ExecGetResultType(outerNode),
+										  plannode->sort.numCols,
+										  plannode->sort.sortColIdx,
+										  plannode->sort.sortOperators,
+										  plannode->sort.collations,
+										  plannode->sort.nullsFirst,
+										  work_mem,
+										  NULL, false);
+
+	/*
+	 * Batches sort after each other, so this batch needs to produce only as
+	 * many tuples as the earlier ones didn't.
+	 */
+	if (node->bounded)
+		tuplesort_set_bound(tuplesortstate, node->bound - node->bound_Done);
+	node->tuplesortstate = (void *) tuplesortstate;
+
+	/* The tuple that ended the previous batch starts this one */
+	if (!TupIsNull(node->transfer_tuple))
+	{
+		tuplesort_puttupleslot(tuplesortstate, node->transfer_tuple);
+		ExecClearTuple(node->transfer_tuple);
+		ntuples++;
+	}
+
+	for (;;)
+	{
+		TupleTableSlot *slot = ExecProcNode(outerNode);
+
+		if (TupIsNull(slot))
+		{
+			node->outer_done = true;
+			break;
+		}
+
+		if (ntuples < INCREMENTALSORT_MIN_BATCH)
+		{
+			tuplesort_puttupleslot(tuplesortstate, slot);
+			if (++ntuples == INCREMENTALSORT_MIN_BATCH)
+				ExecCopySlot(node->group_pivot, slot);
+			continue;
+		}
+
+		/* Once the batch is big enough, stop at the end of the last group */
+		econtext->ecxt_innertuple = node->group_pivot;
+		econtext->ecxt_outertuple = slot;
+		if (!ExecQualAndReset(node->presorted_eq, econtext))
+		{
+			ExecCopySlot(node->transfer_tuple, slot);
+			break;
+		}
+
+		tuplesort_puttupleslot(tuplesortstate, slot);
+		ntuples++;
+	}
+
+	if (ntuples == 0)
+	{
+		finish_batch(node);
+		return false;
+	}
+
+	tuplesort_performsort(tuplesortstate);
+
+	node->batch_sorted = true;
+	node->nbatches++;
+	if (node->bounded)
+		node->bound_Done = Min(node->bound, node->bound_Done + ntuples);
+
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSort
+ *
+ *		Returns the tuples of the current batch in sorted order; when it
+ *		is used up, reads and sorts the next batch from the outer subtree.
+ *
+ *		Conditions:
+ *		  -- none.
+ *
+ *		Initial States:
+ *		  -- the outer child is prepared to return the first tuple.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecIncrementalSort(PlanState *pstate)
+{
+	IncrementalSortState *node = castNode(IncrementalSortState, pstate);
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+
+	CHECK_FOR_INTERRUPTS();
+
+	for (;;)
+	{
+		if (node->batch_sorted)
+		{
+			/*
+			 * Note that we only rely on slot tuple remaining valid until the
+			 * next fetch from the tuplesort.
+			 */
+			if (tuplesort_gettupleslot((Tuplesortstate *) node->tuplesortstate,
+									   true, false, slot, NULL))
+				return slot;
+
+			finish_batch(node);
+		}
+
+		if (!load_next_batch(node))
+			return ExecClearTuple(slot);
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitIncrementalSort
+ *
+ *		Creates the run-time state information for the incremental sort
+ *		node produced by the planner and initializes its outer subtree.
+ * ----------------------------------------------------------------
+ */
+IncrementalSortState *
+ExecInitIncrementalSort(IncrementalSort *node, EState *estate, int eflags)
+{
+	IncrementalSortState *incrsortstate;
+	TupleDesc	tupDesc;
+	Oid		   *eqOperators;
+	int			i;
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "initializing incremental sort node");
+
+	/* Batches are thrown away once returned, so we can't go back */
+	Assert((eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) == 0);
+
+	/*
+	 * create state structure
+	 */
+	incrsortstate = makeNode(IncrementalSortState);
+	incrsortstate->ss.ps.plan = (Plan *) node;
+	incrsortstate->ss.ps.state = estate;
+	incrsortstate->ss.ps.ExecProcNode = ExecIncrementalSort;
+
+	incrsortstate->bounded = false;
+	incrsortstate->batch_sorted = false;
+	incrsortstate->outer_done = false;
+	incrsortstate->tuplesortstate = NULL;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * We need an ExprContext to compare the presorted columns.
+	 */
+	ExecAssignExprContext(estate, &incrsortstate->ss.ps);
+
+	/*
+	 * initialize child nodes
+	 *
+	 * We shield the child node from the need to support REWIND, BACKWARD, or
+	 * MARK/RESTORE.
+	 */
+	eflags &= ~(EXEC_FLAG_REWIND | EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK);
+
+	outerPlanState(incrsortstate) = ExecInitNode(outerPlan(node), estate, eflags);
+
+	/*
+	 * Initialize scan slot and type.
+	 */
+	ExecCreateScanSlotFromOuterPlan(estate, &incrsortstate->ss, &TTSOpsVirtual);
+	tupDesc = ExecGetResultType(outerPlanState(incrsortstate));
+
+	/*
+	 * Initialize return slot and type. No need to initialize projection info
+	 * because this node doesn't do projections.
+	 */
+	ExecInitResultTupleSlotTL(&incrsortstate->ss.ps, &TTSOpsMinimalTuple);
+	incrsortstate->ss.ps.ps_ProjInfo = NULL;
+
+	/* Slots to keep tuples across the boundary of a batch */
+	incrsortstate->group_pivot = ExecInitExtraTupleSlot(estate, tupDesc,
+														&TTSOpsMinimalTuple);
+	incrsortstate->transfer_tuple = ExecInitExtraTupleSlot(estate, tupDesc,
+														   &TTSOpsMinimalTuple);
+
+	/*
+	 * Precompute the equality test of the presorted columns, using the
+	 * equality operators that go with the sort operators.
+	 */
+	eqOperators = (Oid *) palloc(node->nPresortedCols * sizeof(Oid));
+	for (i = 0; i < node->nPresortedCols; i++)
+	{
+		eqOperators[i] = get_equality_op_for_ordering_op(node->sort.sortOperators[i],
+														 NULL);
+		if (!OidIsValid(eqOperators[i]))
+			elog(ERROR, "missing equality operator for ordering operator %u",
+				 node->sort.sortOperators[i]);
+	}
+	incrsortstate->presorted_eq =
+		execTuplesMatchPrepare(tupDesc,
+							   node->nPresortedCols,
+							   node->sort.sortColIdx,
+							   eqOperators,
+							   node->sort.collations,
+							   &incrsortstate->ss.ps);
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "incremental sort node initialized");
+
+	return incrsortstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndIncrementalSort(node)
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndIncrementalSort(IncrementalSortState *node)
+{
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "shutting down incremental sort node");
+
+	/*
+	 * clean out the tuple table
+	 */
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	/* must drop pointer to sort result tuple */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+	ExecClearTuple(node->transfer_tuple);
+
+	/*
+	 * Release tuplesort resources
+	 */
+	finish_batch(node);
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "incremental sort node shutdown");
+}
+
+void
+ExecReScanIncrementalSort(IncrementalSortState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	/*
+	 * Sorted batches aren't kept once they have been returned, so we always
+	 * have to re-read the subplan.
+	 */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+	ExecClearTuple(node->transfer_tuple);
+	finish_batch(node);
+
+	node->outer_done = false;
+	node->bound_Done = 0;
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+}
@@ -49,6 +49,7 @@
 #include "foreign/fdwapi.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
+#include "optimizer/optimizer.h"
 #include "rewrite/rewriteHandler.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
@@ -58,6 +59,13 @@
 #include "utils/rel.h"
 
 
+/*
+ * Limits on the number of tuples, and their total size, buffered by a batched
+ * INSERT before they are flushed to the table.
+ */
+#define MAX_INSERT_BATCH_TUPLES		1000
+#define MAX_INSERT_BATCH_BYTES		65536
+
 static bool ExecOnConflictUpdate(ModifyTableState *mtstate,
 								 ResultRelInfo *resultRelInfo,
 								 ItemPointer conflictTid,
@@ -75,6 +83,9 @@ static ResultRelInfo *getTargetResultRelInfo(ModifyTableState *node);
 static void ExecSetupChildParentMapForSubplan(ModifyTableState *mtstate);
 static TupleConversionMap *tupconv_map_for_subplan(ModifyTableState *node,
 												   int whichplan);
+static void ExecBufferInsert(ModifyTableState *mtstate, EState *estate,
+							 TupleTableSlot *slot);
+static void ExecFlushInsertBatch(ModifyTableState *mtstate, EState *estate);
 
 /*
  * Verify that the tuples to be produced by INSERT or UPDATE match the
@@ -337,6 +348,108 @@ ExecComputeStoredGenerated(EState *estate, TupleTableSlot *slot)
 	MemoryContextSwitchTo(oldContext);
 }
 
+/*
+ * Buffer a tuple to be inserted into the result relation as part of a batch.
+ *
+ * The batch is flushed when it grows too large, and at the end of the
+ * ModifyTable node's processing.  See ExecInitModifyTable for the conditions
+ * under which inserts are batched.
+ */
+static void
+ExecBufferInsert(ModifyTableState *mtstate, EState *estate,
+				 TupleTableSlot *slot)
+{
+	ResultRelInfo *resultRelInfo = estate->es_result_relation_info;
+	TupleTableSlot *batchslot;
+
+	Assert(mtstate->mt_batch_insert);
+	Assert(mtstate->mt_batch_nused < MAX_INSERT_BATCH_TUPLES);
+
+	if (mtstate->mt_batch_slots == NULL)
+		mtstate->mt_batch_slots = (TupleTableSlot **)
+			palloc0(sizeof(TupleTableSlot *) * MAX_INSERT_BATCH_TUPLES);
+
+	batchslot = mtstate->mt_batch_slots[mtstate->mt_batch_nused];
+	if (batchslot == NULL)
+	{
+		batchslot = table_slot_create(resultRelInfo->ri_RelationDesc,
+									  &estate->es_tupleTable);
+		mtstate->mt_batch_slots[mtstate->mt_batch_nused] = batchslot;
+	}
+
+	/* Estimate the size of the tuple, for deciding when to flush */
+	slot_getallattrs(slot);
+	mtstate->mt_batch_bytes += heap_compute_data_size(slot->tts_tupleDescriptor,
+													  slot->tts_values,
+													  slot->tts_isnull);
+
+	ExecCopySlot(batchslot, slot);
+	mtstate->mt_batch_nused++;
+
+	if (mtstate->mt_batch_nused >= MAX_INSERT_BATCH_TUPLES ||
+		mtstate->mt_batch_bytes >= MAX_INSERT_BATCH_BYTES)
+		ExecFlushInsertBatch(mtstate, estate);
+}
+
+/*
+ * Insert all buffered tuples into the result relation, and update its
+ * indexes.
+ *
+ * The tuples are handed to the table AM in one table_multi_insert() call,
+ * which for heap tables packs all tuples that go to the same page into a
+ * single WAL record, instead of emitting a full record header and block
+ * reference for every row.
+ */
+static void
+ExecFlushInsertBatch(ModifyTableState *mtstate, EState *estate)
+{
+	ResultRelInfo *resultRelInfo = estate->es_result_relation_info;
+	TupleTableSlot **slots = mtstate->mt_batch_slots;
+	int			nused = mtstate->mt_batch_nused;
+	MemoryContext oldcontext;
+	int			i;
+
+	if (nused == 0)
+		return;
+
+	/*
+	 * table_multi_insert may leak memory, so switch to short-lived memory
+	 * context before calling it.
+	 */
+	oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+	table_multi_insert(resultRelInfo->ri_RelationDesc,
+					   slots,
+					   nused,
+					   estate->es_output_cid,
+					   0,
+					   NULL);
+	MemoryContextSwitchTo(oldcontext);
+
+	/* insert index entries for the tuples */
+	if (resultRelInfo->ri_NumIndices > 0)
+	{
+		for (i = 0; i < nused; i++)
+		{
+			List	   *recheckIndexes;
+
+			recheckIndexes = ExecInsertIndexTuples(slots[i], estate, false,
+												   NULL, NIL);
+			/* only deferrable constraints need rechecks; we have none */
+			Assert(recheckIndexes == NIL);
+			list_free(recheckIndexes);
+		}
+	}
+
+	if (mtstate->canSetTag)
+		setLastTid(&slots[nused - 1]->tts_tid);
+
+	for (i = 0; i < nused; i++)
+		ExecClearTuple(slots[i]);
+
+	mtstate->mt_batch_nused = 0;
+	mtstate->mt_batch_bytes = 0;
+}
+
 /* ----------------------------------------------------------------
  *		ExecInsert
  *
@@ -587,6 +700,20 @@ ExecInsert(ModifyTableState *mtstate,
 
 			/* Since there was no insertion conflict, we're done */
 		}
+		else if (mtstate->mt_batch_insert)
+		{
+			/*
+			 * Buffer the tuple, to be inserted later along with others.
+			 * There are no AFTER ROW triggers, WITH CHECK OPTIONs or
+			 * RETURNING to process, so we're done with it.
+			 */
+			ExecBufferInsert(mtstate, estate, slot);
+
+			if (canSetTag)
+				(estate->es_processed)++;
+
+			return NULL;
+		}
 		else
 		{
 			/* insert the tuple normally */
@@ -2251,6 +2378,10 @@ ExecModifyTable(PlanState *pstate)
 		}
 	}
 
+	/* Insert any tuples that are still buffered */
+	if (node->mt_batch_insert)
+		ExecFlushInsertBatch(node, estate);
+
 	/* Restore es_result_relation_info before exiting */
 	estate->es_result_relation_info = saved_resultRelInfo;
 
@@ -2724,6 +2855,44 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
 		}
 	}
 
+	/*
+	 * Decide whether the tuples of a multi-row INSERT ... VALUES can be
+	 * inserted in batches.  Tuples are buffered and inserted with
+	 * table_multi_insert(), which is a lot cheaper than inserting them one by
+	 * one, especially in terms of WAL volume.  That's only OK if nothing
+	 * needs to see the individual tuples right after they have been
+	 * inserted: no AFTER ROW triggers or transition tables, no RETURNING, no
+	 * WITH CHECK OPTIONs, and no ON CONFLICT.  For simplicity, we also
+	 * insist on a plain table that doesn't need tuple routing.
+	 *
+	 * Also, the VALUES lists must not contain volatile functions, because
+	 * those might run queries that could see the difference.  nextval() is
+	 * harmless, however, and very common in column defaults.
+	 */
+	if (operation == CMD_INSERT && nplans == 1 &&
+		node->onConflictAction == ONCONFLICT_NONE &&
+		node->returningLists == NIL &&
+		node->withCheckOptionLists == NIL &&
+		mtstate->mt_partition_tuple_routing == NULL &&
+		mtstate->mt_transition_capture == NULL &&
+		IsA(linitial(node->plans), ValuesScan))
+	{
+		ValuesScan *valuesscan = (ValuesScan *) linitial(node->plans);
+		TriggerDesc *trigdesc;
+
+		resultRelInfo = mtstate->resultRelInfo;
+		trigdesc = resultRelInfo->ri_TrigDesc;
+
+		if (resultRelInfo->ri_RelationDesc->rd_rel->relkind == RELKIND_RELATION &&
+			resultRelInfo->ri_FdwRoutine == NULL &&
+			(trigdesc == NULL ||
+			 (!trigdesc->trig_insert_before_row &&
+			  !trigdesc->trig_insert_after_row &&
+			  !trigdesc->trig_insert_instead_row)) &&
+			!contain_volatile_functions_not_nextval((Node *) valuesscan->values_lists))
+			mtstate->mt_batch_insert = true;
+	}
+
 	/*
 	 * Lastly, if this is not the primary (canSetTag) ModifyTable node, add it
 	 * to estate->es_auxmodifytables so that it will be run to completion by
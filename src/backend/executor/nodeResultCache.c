@@ -0,0 +1,772 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeResultCache.c
+ *	  Routines to handle caching of results from parameterized nodes
+ *
+ * A Result Cache node sits above a parameterized subplan, typically the inner
+ * side of a nested loop join, and remembers the tuples the subplan returned
+ * for each set of parameter values.  When the node is rescanned with
+ * parameter values that are in the cache, the cached tuples are returned and
+ * the subplan is not executed at all.  This saves a lot of work when the
+ * outer side of the join has many duplicate join keys.
+ *
+ * The cache is a hash table keyed by the values of the cache key
+ * expressions, which contain the parameters.  It is limited to work_mem;
+ * when it is full, the least recently used entries are evicted.  An entry is
+ * only used once the subplan has been read to completion for it, since the
+ * parent node may stop reading early.  If the tuples of a single scan don't
+ * fit in the cache at all, the rest of that scan is just passed through.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeResultCache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "executor/executor.h"
+#include "executor/nodeResultCache.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "utils/hashutils.h"
+#include "utils/lsyscache.h"
+
+/* States of the ExecResultCache state machine */
+#define RC_CACHE_LOOKUP				1	/* attempt to perform a cache lookup */
+#define RC_CACHE_FETCH_NEXT_TUPLE	2	/* get another tuple from the cache */
+#define RC_FILLING_CACHE			3	/* read subplan to fill cache */
+#define RC_CACHE_BYPASS_MODE		4	/* bypass mode, just read from subplan
+										 * without caching anything */
+#define RC_END_OF_SCAN				5	/* ready for rescan */
+
+/* default number of hash table buckets if the planner didn't estimate it */
+#define RC_DEFAULT_ENTRIES			1024
+
+/* Memory accounted for a cache entry without any tuples */
+#define EMPTY_ENTRY_MEMORY_BYTES(e)		(sizeof(ResultCacheEntry) + \
+										 sizeof(ResultCacheKey) + \
+										 (e)->key->params->t_len)
+/* Memory accounted for a cached tuple */
+#define CACHE_TUPLE_BYTES(t)			(sizeof(ResultCacheTuple) + \
+										 (t)->mintuple->t_len)
+
+/* a tuple stored in a cache entry */
+typedef struct ResultCacheTuple
+{
+	MinimalTuple mintuple;		/* cached tuple */
+	struct ResultCacheTuple *next;	/* next tuple of the same entry, or NULL */
+} ResultCacheTuple;
+
+/*
+ * The key of a cache entry.  It is kept separately from the entry itself,
+ * because simplehash moves entries around; the key stays where it is, so it
+ * can carry the LRU list links.
+ */
+typedef struct ResultCacheKey
+{
+	MinimalTuple params;		/* values of the cache key expressions */
+	dlist_node	lru_node;		/* position in the LRU list */
+} ResultCacheKey;
+
+/* a hash table entry */
+typedef struct ResultCacheEntry
+{
+	ResultCacheKey *key;		/* hash key of the entry */
+	ResultCacheTuple *tuplehead;	/* first cached tuple, or NULL */
+	uint32		hash;			/* hash value (cached) */
+	char		status;			/* hash status */
+	bool		complete;		/* have all tuples of the scan been cached? */
+} ResultCacheEntry;
+
+
+static uint32 ResultCacheHash_hash(struct resultcache_hash *tb,
+								   const ResultCacheKey *key);
+static bool ResultCacheHash_equal(struct resultcache_hash *tb,
+								  const ResultCacheKey *key1,
+								  const ResultCacheKey *key2);
+
+#define SH_PREFIX resultcache
+#define SH_ELEMENT_TYPE ResultCacheEntry
+#define SH_KEY_TYPE ResultCacheKey *
+#define SH_KEY key
+#define SH_HASH_KEY(tb, key) ResultCacheHash_hash(tb, key)
+#define SH_EQUAL(tb, a, b) ResultCacheHash_equal(tb, a, b)
+#define SH_SCOPE static inline
+#define SH_STORE_HASH
+#define SH_GET_HASH(tb, a) a->hash
+#define SH_DECLARE
+#define SH_DEFINE
+#include "lib/simplehash.h"
+
+/*
+ * Hash the key in the probe slot.  The key argument is not used: all the
+ * lookups set up the probe slot beforehand with prepare_probe_slot(), and
+ * simplehash only needs to hash new keys, since it stores the hash values.
+ */
+static uint32
+ResultCacheHash_hash(struct resultcache_hash *tb, const ResultCacheKey *key)
+{
+	ResultCacheState *rcstate = (ResultCacheState *) tb->private_data;
+	TupleTableSlot *pslot = rcstate->probeslot;
+	uint32		hashkey = 0;
+	int			i;
+
+	for (i = 0; i < rcstate->nkeys; i++)
+	{
+		/* rotate hashkey left 1 bit at each step */
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		if (!pslot->tts_isnull[i])	/* treat nulls as having hash key 0 */
+		{
+			uint32		hkey;
+
+			hkey = DatumGetUInt32(FunctionCall1Coll(&rcstate->hashfunctions[i],
+													rcstate->collations[i],
+													pslot->tts_values[i]));
+			hashkey ^= hkey;
+		}
+	}
+
+	return murmurhash32(hashkey);
+}
+
+/*
+ * Compare the key of an existing entry, key1, with the key in the probe slot.
+ * key2 is not used, see ResultCacheHash_hash.
+ */
+static bool
+ResultCacheHash_equal(struct resultcache_hash *tb, const ResultCacheKey *key1,
+					  const ResultCacheKey *key2)
+{
+	ResultCacheState *rcstate = (ResultCacheState *) tb->private_data;
+	ExprContext *econtext = rcstate->ss.ps.ps_ExprContext;
+	TupleTableSlot *tslot = rcstate->tableslot;
+
+	ExecStoreMinimalTuple(key1->params, tslot, false);
+
+	econtext->ecxt_innertuple = tslot;
+	econtext->ecxt_outertuple = rcstate->probeslot;
+	return ExecQual(rcstate->cache_eq_expr, econtext);
+}
+
+/*
+ * Fill the probe slot with the values of the given key, or with the current
+ * values of the cache key expressions if key is NULL.
+ */
+static void
+prepare_probe_slot(ResultCacheState *rcstate, ResultCacheKey *key)
+{
+	TupleTableSlot *pslot = rcstate->probeslot;
+	TupleTableSlot *tslot = rcstate->tableslot;
+	int			nkeys = rcstate->nkeys;
+	int			i;
+
+	ExecClearTuple(pslot);
+
+	if (key == NULL)
+	{
+		ExprContext *econtext = rcstate->ss.ps.ps_ExprContext;
+		MemoryContext oldcontext;
+
+		/*
+		 * The values live in per-tuple memory until the next lookup, which
+		 * also gets rid of anything the equality functions leaked.
+		 */
+		ResetExprContext(econtext);
+		oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+		for (i = 0; i < nkeys; i++)
+			pslot->tts_values[i] = ExecEvalExpr(rcstate->param_exprs[i],
+												econtext,
+												&pslot->tts_isnull[i]);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+	else
+	{
+		ExecStoreMinimalTuple(key->params, tslot, false);
+		slot_getallattrs(tslot);
+		memcpy(pslot->tts_values, tslot->tts_values, sizeof(Datum) * nkeys);
+		memcpy(pslot->tts_isnull, tslot->tts_isnull, sizeof(bool) * nkeys);
+	}
+
+	ExecStoreVirtualTuple(pslot);
+}
+
+/*
+ * Create an empty hash table, in the memory context of the cache.
+ */
+static void
+build_hash_table(ResultCacheState *rcstate, uint32 size)
+{
+	if (size == 0)
+		size = RC_DEFAULT_ENTRIES;
+
+	/* resultcache_create will convert the size to a power of 2 */
+	rcstate->hashtable = resultcache_create(rcstate->tableContext, size,
+											rcstate);
+}
+
+/*
+ * Remove all the tuples of a cache entry, leaving it empty and incomplete.
+ */
+static void
+entry_purge_tuples(ResultCacheState *rcstate, ResultCacheEntry *entry)
+{
+	ResultCacheTuple *tuple = entry->tuplehead;
+
+	while (tuple != NULL)
+	{
+		ResultCacheTuple *next = tuple->next;
+
+		rcstate->mem_used -= CACHE_TUPLE_BYTES(tuple);
+		pfree(tuple->mintuple);
+		pfree(tuple);
+
+		tuple = next;
+	}
+
+	entry->complete = false;
+	entry->tuplehead = NULL;
+}
+
+/*
+ * Remove an entry from the cache.  The probe slot must contain the key of the
+ * entry.
+ */
+static void
+remove_cache_entry(ResultCacheState *rcstate, ResultCacheEntry *entry)
+{
+	ResultCacheKey *key = entry->key;
+
+	dlist_delete(&key->lru_node);
+
+	entry_purge_tuples(rcstate, entry);
+	rcstate->mem_used -= EMPTY_ENTRY_MEMORY_BYTES(entry);
+
+	resultcache_delete(rcstate->hashtable, NULL);
+
+	pfree(key->params);
+	pfree(key);
+}
+
+/*
+ * Remove all entries from the cache.
+ */
+static void
+cache_purge_all(ResultCacheState *rcstate)
+{
+	MemoryContextReset(rcstate->tableContext);
+
+	dlist_init(&rcstate->lru_list);
+	rcstate->last_tuple = NULL;
+	rcstate->entry = NULL;
+	rcstate->mem_used = 0;
+
+	build_hash_table(rcstate, ((ResultCache *) rcstate->ss.ps.plan)->est_entries);
+}
+
+/*
+ * Evict least recently used entries until the cache fits in its memory
+ * limit again.
+ *
+ * Returns false if the entry with key 'specialkey' had to be evicted too,
+ * which the caller is usually still filling.
+ */
+static bool
+cache_reduce_memory(ResultCacheState *rcstate, ResultCacheKey *specialkey)
+{
+	bool		specialkey_intact = true;
+	dlist_mutable_iter iter;
+
+	Assert(rcstate->mem_used > rcstate->mem_limit);
+
+	dlist_foreach_modify(iter, &rcstate->lru_list)
+	{
+		ResultCacheKey *key = dlist_container(ResultCacheKey, lru_node,
+											  iter.cur);
+		ResultCacheEntry *entry;
+
+		/*
+		 * We only have the key of the entry, since the entry itself may have
+		 * been moved by the hash table code, so look it up.
+		 */
+		prepare_probe_slot(rcstate, key);
+		entry = resultcache_lookup(rcstate->hashtable, NULL);
+
+		Assert(entry != NULL && entry->key == key);
+
+		if (key == specialkey)
+			specialkey_intact = false;
+
+		remove_cache_entry(rcstate, entry);
+		rcstate->cache_evictions++;
+
+		if (rcstate->mem_used <= rcstate->mem_limit)
+			break;
+	}
+
+	return specialkey_intact;
+}
+
+/*
+ * Find the cache entry for the current parameter values, or create an empty
+ * one.  *found is set to tell which.
+ *
+ * Returns NULL if there is no room even for an empty entry.
+ */
+static ResultCacheEntry *
+cache_lookup(ResultCacheState *rcstate, bool *found)
+{
+	ResultCacheKey *key;
+	ResultCacheEntry *entry;
+	MemoryContext oldcontext;
+
+	prepare_probe_slot(rcstate, NULL);
+
+	entry = resultcache_insert(rcstate->hashtable, NULL, found);
+
+	if (*found)
+	{
+		/* Mark the entry as the most recently used one */
+		dlist_delete(&entry->key->lru_node);
+		dlist_push_tail(&rcstate->lru_list, &entry->key->lru_node);
+
+		return entry;
+	}
+
+	oldcontext = MemoryContextSwitchTo(rcstate->tableContext);
+
+	entry->key = key = (ResultCacheKey *) palloc(sizeof(ResultCacheKey));
+	key->params = ExecCopySlotMinimalTuple(rcstate->probeslot);
+	entry->tuplehead = NULL;
+	entry->complete = false;
+
+	dlist_push_tail(&rcstate->lru_list, &key->lru_node);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	rcstate->mem_used += EMPTY_ENTRY_MEMORY_BYTES(entry);
+	rcstate->mem_peak = Max(rcstate->mem_peak, rcstate->mem_used);
+	rcstate->last_tuple = NULL;
+
+	if (rcstate->mem_used > rcstate->mem_limit)
+	{
+		if (!cache_reduce_memory(rcstate, key))
+			return NULL;
+
+		/*
+		 * Removing entries may have moved ours within the hash table, in which
+		 * case we have to look it up again.
+		 */
+		if (entry->status != resultcache_SH_IN_USE || entry->key != key)
+		{
+			prepare_probe_slot(rcstate, key);
+			entry = resultcache_lookup(rcstate->hashtable, NULL);
+			Assert(entry != NULL);
+		}
+	}
+
+	return entry;
+}
+
+/*
+ * Add a copy of the tuple in 'slot' to the current cache entry.
+ *
+ * Returns false if the current entry had to be evicted to stay within the
+ * memory limit.
+ */
+static bool
+cache_store_tuple(ResultCacheState *rcstate, TupleTableSlot *slot)
+{
+	ResultCacheEntry *entry = rcstate->entry;
+	ResultCacheTuple *tuple;
+	MemoryContext oldcontext;
+
+	Assert(entry != NULL);
+
+	oldcontext = MemoryContextSwitchTo(rcstate->tableContext);
+
+	tuple = (ResultCacheTuple *) palloc(sizeof(ResultCacheTuple));
+	tuple->mintuple = ExecCopySlotMinimalTuple(slot);
+	tuple->next = NULL;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	rcstate->mem_used += CACHE_TUPLE_BYTES(tuple);
+	rcstate->mem_peak = Max(rcstate->mem_peak, rcstate->mem_used);
+
+	if (entry->tuplehead == NULL)
+		entry->tuplehead = tuple;
+	else
+		rcstate->last_tuple->next = tuple;
+	rcstate->last_tuple = tuple;
+
+	if (rcstate->mem_used > rcstate->mem_limit)
+	{
+		ResultCacheKey *key = entry->key;
+
+		if (!cache_reduce_memory(rcstate, key))
+			return false;
+
+		/* See cache_lookup */
+		if (entry->status != resultcache_SH_IN_USE || entry->key != key)
+		{
+			prepare_probe_slot(rcstate, key);
+			rcstate->entry = entry = resultcache_lookup(rcstate->hashtable,
+														NULL);
+			Assert(entry != NULL);
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Collect the ids of the PARAM_EXEC Params in an expression tree.
+ */
+static bool
+collect_paramids_walker(Node *node, Bitmapset **paramids)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Param))
+	{
+		Param	   *param = (Param *) node;
+
+		if (param->paramkind == PARAM_EXEC)
+			*paramids = bms_add_member(*paramids, param->paramid);
+		return false;
+	}
+	return expression_tree_walker(node, collect_paramids_walker,
+								  (void *) paramids);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecResultCache
+ *
+ *		On the first call after a rescan, look up the current parameter
+ *		values in the cache.  If a complete entry is found, return its
+ *		tuples; otherwise return the tuples of the subplan, storing them in
+ *		a new entry as we go.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecResultCache(PlanState *pstate)
+{
+	ResultCacheState *node = castNode(ResultCacheState, pstate);
+	PlanState  *outerNode = outerPlanState(node);
+	TupleTableSlot *outerslot;
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+
+	switch (node->rc_status)
+	{
+		case RC_CACHE_LOOKUP:
+			{
+				ResultCacheEntry *entry;
+				bool		found;
+
+				Assert(node->entry == NULL);
+
+				entry = cache_lookup(node, &found);
+
+				if (found && entry->complete)
+				{
+					node->cache_hits++;
+
+					node->entry = entry;
+					node->last_tuple = entry->tuplehead;
+
+					if (entry->tuplehead == NULL)
+					{
+						/* the subplan returned nothing for these parameters */
+						node->rc_status = RC_END_OF_SCAN;
+						return NULL;
+					}
+
+					node->rc_status = RC_CACHE_FETCH_NEXT_TUPLE;
+					ExecStoreMinimalTuple(entry->tuplehead->mintuple, slot,
+										  false);
+					return slot;
+				}
+
+				node->cache_misses++;
+
+				/*
+				 * An entry whose scan was not run to completion is useless;
+				 * start it over.  We can't resume where it stopped, since the
+				 * subplan might not return tuples in the same order again.
+				 */
+				if (found)
+					entry_purge_tuples(node, entry);
+
+				outerslot = ExecProcNode(outerNode);
+				if (TupIsNull(outerslot))
+				{
+					/* entry is NULL if there was no room for it */
+					if (entry != NULL)
+						entry->complete = true;
+					node->rc_status = RC_END_OF_SCAN;
+					return NULL;
+				}
+
+				node->entry = entry;
+
+				if (entry == NULL || !cache_store_tuple(node, outerslot))
+				{
+					/* The scan doesn't fit in the cache, so stop caching it */
+					node->cache_overflows++;
+					node->rc_status = RC_CACHE_BYPASS_MODE;
+				}
+				else
+				{
+					/*
+					 * If the scan can return at most one tuple, the entry is
+					 * complete already, even if our parent doesn't ask for
+					 * the end of the scan.
+					 */
+					node->entry->complete = node->singlerow;
+					node->rc_status = RC_FILLING_CACHE;
+				}
+
+				return ExecCopySlot(slot, outerslot);
+			}
+
+		case RC_CACHE_FETCH_NEXT_TUPLE:
+			Assert(node->last_tuple != NULL);
+
+			node->last_tuple = node->last_tuple->next;
+			if (node->last_tuple == NULL)
+			{
+				node->rc_status = RC_END_OF_SCAN;
+				return NULL;
+			}
+
+			ExecStoreMinimalTuple(node->last_tuple->mintuple, slot, false);
+			return slot;
+
+		case RC_FILLING_CACHE:
+			Assert(node->entry != NULL);
+
+			outerslot = ExecProcNode(outerNode);
+			if (TupIsNull(outerslot))
+			{
+				node->entry->complete = true;
+				node->rc_status = RC_END_OF_SCAN;
+				return NULL;
+			}
+
+			/* the planner promised that there'd be only one tuple */
+			if (node->entry->complete)
+				elog(ERROR, "cache entry already complete");
+
+			if (!cache_store_tuple(node, outerslot))
+			{
+				node->cache_overflows++;
+				node->rc_status = RC_CACHE_BYPASS_MODE;
+			}
+
+			return ExecCopySlot(slot, outerslot);
+
+		case RC_CACHE_BYPASS_MODE:
+			outerslot = ExecProcNode(outerNode);
+			if (TupIsNull(outerslot))
+			{
+				node->rc_status = RC_END_OF_SCAN;
+				return NULL;
+			}
+
+			return ExecCopySlot(slot, outerslot);
+
+		case RC_END_OF_SCAN:
+			return NULL;
+
+		default:
+			elog(ERROR, "unrecognized result cache state: %d",
+				 node->rc_status);
+			return NULL;		/* keep compiler quiet */
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitResultCache
+ * ----------------------------------------------------------------
+ */
+ResultCacheState *
+ExecInitResultCache(ResultCache *node, EState *estate, int eflags)
+{
+	ResultCacheState *rcstate;
+	AttrNumber *keyColIdx;
+	ListCell   *lc;
+	int			nkeys;
+	int			i;
+
+	/* check for unsupported flags */
+	Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
+
+	/*
+	 * create state structure
+	 */
+	rcstate = makeNode(ResultCacheState);
+	rcstate->ss.ps.plan = (Plan *) node;
+	rcstate->ss.ps.state = estate;
+	rcstate->ss.ps.ExecProcNode = ExecResultCache;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * We need an ExprContext to compute and compare the cache keys.
+	 */
+	ExecAssignExprContext(estate, &rcstate->ss.ps);
+
+	/*
+	 * initialize child nodes
+	 */
+	outerPlanState(rcstate) = ExecInitNode(outerPlan(node), estate, eflags);
+
+	/*
+	 * Initialize result type and slot. No need to initialize projection info
+	 * because this node doesn't do projections.
+	 */
+	ExecInitResultTupleSlotTL(&rcstate->ss.ps, &TTSOpsMinimalTuple);
+	rcstate->ss.ps.ps_ProjInfo = NULL;
+
+	/*
+	 * Set up the cache keys: their expressions, the slots to look them up
+	 * and the functions to hash and compare them.
+	 */
+	rcstate->nkeys = nkeys = node->numKeys;
+	rcstate->hashkeydesc = ExecTypeFromExprList(node->param_exprs);
+	rcstate->tableslot = ExecInitExtraTupleSlot(estate, rcstate->hashkeydesc,
+												&TTSOpsMinimalTuple);
+	rcstate->probeslot = ExecInitExtraTupleSlot(estate, rcstate->hashkeydesc,
+												&TTSOpsVirtual);
+
+	rcstate->param_exprs = (ExprState **) palloc(nkeys * sizeof(ExprState *));
+	rcstate->hashfunctions = (FmgrInfo *) palloc(nkeys * sizeof(FmgrInfo));
+	rcstate->collations = node->collations;
+	keyColIdx = (AttrNumber *) palloc(nkeys * sizeof(AttrNumber));
+
+	i = 0;
+	foreach(lc, node->param_exprs)
+	{
+		Expr	   *param_expr = (Expr *) lfirst(lc);
+		Oid			left_hashfn;
+		Oid			right_hashfn;
+
+		if (!get_op_hash_functions(node->hashOperators[i],
+								   &left_hashfn, &right_hashfn))
+			elog(ERROR, "could not find hash function for hash operator %u",
+				 node->hashOperators[i]);
+		fmgr_info(left_hashfn, &rcstate->hashfunctions[i]);
+
+		rcstate->param_exprs[i] = ExecInitExpr(param_expr,
+											   (PlanState *) rcstate);
+		keyColIdx[i] = i + 1;
+		i++;
+	}
+
+	rcstate->cache_eq_expr = execTuplesMatchPrepare(rcstate->hashkeydesc,
+													nkeys,
+													keyColIdx,
+													node->hashOperators,
+													node->collations,
+													&rcstate->ss.ps);
+
+	rcstate->keyparamids = NULL;
+	(void) collect_paramids_walker((Node *) node->param_exprs,
+								   &rcstate->keyparamids);
+
+	/*
+	 * Create the cache itself.
+	 */
+	rcstate->mem_used = 0;
+	rcstate->mem_limit = work_mem * 1024L;
+	rcstate->tableContext = AllocSetContextCreate(CurrentMemoryContext,
+												  "ResultCacheHashTable",
+												  ALLOCSET_DEFAULT_SIZES);
+	dlist_init(&rcstate->lru_list);
+	build_hash_table(rcstate, node->est_entries);
+
+	rcstate->rc_status = RC_CACHE_LOOKUP;
+	rcstate->last_tuple = NULL;
+	rcstate->entry = NULL;
+	rcstate->singlerow = node->singlerow;
+
+	rcstate->cache_hits = 0;
+	rcstate->cache_misses = 0;
+	rcstate->cache_evictions = 0;
+	rcstate->cache_overflows = 0;
+	rcstate->mem_peak = 0;
+
+	return rcstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndResultCache
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndResultCache(ResultCacheState *node)
+{
+	/*
+	 * Free the cache
+	 */
+	MemoryContextDelete(node->tableContext);
+
+	/*
+	 * Free the exprcontext
+	 */
+	ExecFreeExprContext(&node->ss.ps);
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+}
+
+/* ----------------------------------------------------------------
+ *		ExecReScanResultCache
+ * ----------------------------------------------------------------
+ */
+void
+ExecReScanResultCache(ResultCacheState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	/* Look up the new parameter values on the next call */
+	node->rc_status = RC_CACHE_LOOKUP;
+	node->entry = NULL;
+	node->last_tuple = NULL;
+
+	/*
+	 * The cached tuples are only valid for the current values of any other
+	 * Params the subplan depends on, so forget them all if one changed.
+	 */
+	if (bms_nonempty_difference(outerPlan->chgParam, node->keyparamids))
+		cache_purge_all(node);
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+}
+
+/*
+ * ExecEstimateCacheEntryOverheadBytes
+ *		For use in the planner: estimate the memory needed for a cache entry
+ *		holding 'ntuples' tuples, apart from the tuples themselves.
+ */
+double
+ExecEstimateCacheEntryOverheadBytes(double ntuples)
+{
+	return sizeof(ResultCacheEntry) + sizeof(ResultCacheKey) +
+		sizeof(ResultCacheTuple) * ntuples;
+}
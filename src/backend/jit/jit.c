@@ -42,6 +42,7 @@ bool		jit_tuple_deforming = true;
 double		jit_above_cost = 100000;
 double		jit_inline_above_cost = 500000;
 double		jit_optimize_above_cost = 500000;
+int			jit_tier_up_calls = 0;
 
 static JitProviderCallbacks provider;
 static bool provider_successfully_loaded = false;
@@ -177,7 +178,16 @@ jit_compile_expr(struct ExprState *state)
 
 	/* this also takes !jit_enabled into account */
 	if (provider_init())
+	{
+		/*
+		 * With tiered compilation the expression starts out interpreted, so
+		 * the interpreter has to be ready before the provider takes over.
+		 */
+		if (jit_tier_up_calls > 0)
+			ExecReadyInterpretedExpr(state);
+
 		return provider.compile_expr(state);
+	}
 
 	return false;
 }
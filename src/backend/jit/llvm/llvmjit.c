@@ -199,6 +199,7 @@ llvm_release_context(JitContext *context)
 		LLVMDisposeModule(llvm_context->module);
 		llvm_context->module = NULL;
 	}
+	llvm_forget_deform_functions(llvm_context);
 
 	while (llvm_context->handles != NIL)
 	{
@@ -248,6 +249,9 @@ llvm_mutable_module(LLVMJitContext *context)
 	 */
 	if (!context->module)
 	{
+		/* functions in previously emitted modules can't be referenced */
+		llvm_forget_deform_functions(context);
+
 		context->compiled = false;
 		context->module_generation = llvm_generation++;
 		context->module = LLVMModuleCreateWithName("pg");
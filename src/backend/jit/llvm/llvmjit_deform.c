@@ -27,6 +27,24 @@
 #include "executor/tuptable.h"
 #include "jit/llvmjit.h"
 #include "jit/llvmjit_emit.h"
+#include "utils/memutils.h"
+
+
+/*
+ * A deform function already generated in the current module.  Generated code
+ * depends only on the slot type, the number of attributes to deform, and the
+ * physical layout properties of the descriptor's attributes, so expressions
+ * reading the same kind of tuple (e.g. a scan's qual and its projection) can
+ * share one function.
+ */
+typedef struct LLVMJitDeformFunction
+{
+	const TupleTableSlotOps *ops;
+	int			natts;			/* # of attributes deformed */
+	int			desc_natts;		/* # of attributes in descriptor */
+	FormData_pg_attribute *attrs;	/* copy of descriptor's attributes */
+	LLVMValueRef fn;
+} LLVMJitDeformFunction;
 
 
 /*
@@ -43,8 +61,63 @@
 		(att)->attnum == Anum_pg_subscription_rel_srsublsn)))
 
 
+/*
+ * Does an already generated deform function fit desc, ops and natts?
+ *
+ * Compare everything slot_compile_deform looks at.  attrelid and attnum are
+ * included because of the ATTNOTNULL special case above.
+ */
+static bool
+deform_function_matches(LLVMJitDeformFunction *df, TupleDesc desc,
+						const TupleTableSlotOps *ops, int natts)
+{
+	int			attnum;
+
+	if (df->ops != ops || df->natts != natts || df->desc_natts != desc->natts)
+		return false;
+
+	for (attnum = 0; attnum < desc->natts; attnum++)
+	{
+		Form_pg_attribute a = &df->attrs[attnum];
+		Form_pg_attribute b = TupleDescAttr(desc, attnum);
+
+		if (a->attlen != b->attlen ||
+			a->attbyval != b->attbyval ||
+			a->attalign != b->attalign ||
+			a->attnotnull != b->attnotnull ||
+			a->atthasmissing != b->atthasmissing ||
+			a->attisdropped != b->attisdropped ||
+			a->attrelid != b->attrelid ||
+			a->attnum != b->attnum)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Forget the deform functions generated in the current module.  Must be
+ * called whenever the module is emitted or discarded.
+ */
+void
+llvm_forget_deform_functions(LLVMJitContext *context)
+{
+	ListCell   *lc;
+
+	foreach(lc, context->deform_functions)
+	{
+		LLVMJitDeformFunction *df = (LLVMJitDeformFunction *) lfirst(lc);
+
+		pfree(df->attrs);
+	}
+	list_free_deep(context->deform_functions);
+	context->deform_functions = NIL;
+}
+
 /*
  * Create a function that deforms a tuple of type desc up to natts columns.
+ *
+ * If the current module already has a suitable function, return that.
  */
 LLVMValueRef
 slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
@@ -105,6 +178,10 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	int			attnum;
 
+	ListCell   *lc;
+	LLVMJitDeformFunction *df;
+	MemoryContext oldcontext;
+
 	/* virtual tuples never need deforming, so don't generate code */
 	if (ops == &TTSOpsVirtual)
 		return NULL;
@@ -116,6 +193,14 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	mod = llvm_mutable_module(context);
 
+	foreach(lc, context->deform_functions)
+	{
+		LLVMJitDeformFunction *cached = (LLVMJitDeformFunction *) lfirst(lc);
+
+		if (deform_function_matches(cached, desc, ops, natts))
+			return cached->fn;
+	}
+
 	funcname = llvm_expand_funcname(context, "deform");
 
 	/*
@@ -768,5 +853,19 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	LLVMDisposeBuilder(b);
 
+	/* remember the function for reuse; it lives as long as the context */
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	df = palloc(sizeof(LLVMJitDeformFunction));
+	df->ops = ops;
+	df->natts = natts;
+	df->desc_natts = desc->natts;
+	df->attrs = palloc(sizeof(FormData_pg_attribute) * Max(desc->natts, 1));
+	for (attnum = 0; attnum < desc->natts; attnum++)
+		memcpy(&df->attrs[attnum], TupleDescAttr(desc, attnum),
+			   sizeof(FormData_pg_attribute));
+	df->fn = v_deform_fn;
+	context->deform_functions = lappend(context->deform_functions, df);
+	MemoryContextSwitchTo(oldcontext);
+
 	return v_deform_fn;
 }
@@ -51,10 +51,16 @@ typedef struct CompiledExprState
 {
 	LLVMJitContext *context;
 	const char *funcname;
+
+	/* for tiered compilation, see jit_tier_up_calls */
+	ExprStateEvalFunc interp_func;	/* interpreter's evalfunc, or NULL */
+	int			interp_calls_left;	/* # of evaluations left to interpret */
 } CompiledExprState;
 
 
 static Datum ExecRunCompiledExpr(ExprState *state, ExprContext *econtext, bool *isNull);
+static Datum ExecRunInterpretedExpr(ExprState *state, ExprContext *econtext, bool *isNull);
+static Datum ExecSwitchToCompiledExpr(ExprState *state, ExprContext *econtext, bool *isNull);
 
 static LLVMValueRef BuildV1Call(LLVMJitContext *context, LLVMBuilderRef b,
 								LLVMModuleRef mod, FunctionCallInfo fcinfo,
@@ -2450,6 +2456,19 @@ llvm_compile_expr(ExprState *state)
 		cstate->context = context;
 		cstate->funcname = funcname;
 
+		/*
+		 * If jit_compile_expr() set up the interpreter for tiered
+		 * compilation, remember the interpreter's evalfunc.
+		 * ExecReadyInterpretedExpr() installs ExecInterpExprStillValid,
+		 * with the function that does the actual work in evalfunc_private.
+		 */
+		if (state->flags & EEO_FLAG_INTERPRETER_INITIALIZED)
+		{
+			Assert(state->evalfunc == ExecInterpExprStillValid);
+			cstate->interp_func = (ExprStateEvalFunc) state->evalfunc_private;
+			cstate->interp_calls_left = jit_tier_up_calls;
+		}
+
 		state->evalfunc = ExecRunCompiledExpr;
 		state->evalfunc_private = cstate;
 	}
@@ -2467,18 +2486,59 @@ llvm_compile_expr(ExprState *state)
  * Run compiled expression.
  *
  * This will only be called the first time a JITed expression is called. We
- * first make sure the expression is still up2date, and then get a pointer to
- * the emitted function. The latter can be the first thing that triggers
- * optimizing and emitting all the generated functions.
+ * first make sure the expression is still up2date, and then either start
+ * interpreting it (see jit_tier_up_calls) or switch to the emitted function.
  */
 static Datum
 ExecRunCompiledExpr(ExprState *state, ExprContext *econtext, bool *isNull)
 {
 	CompiledExprState *cstate = state->evalfunc_private;
-	ExprStateEvalFunc func;
 
 	CheckExprStillValid(state, econtext);
 
+	/* with tiered compilation, start out interpreting the expression */
+	if (cstate->interp_func != NULL && cstate->interp_calls_left > 0)
+	{
+		state->evalfunc = ExecRunInterpretedExpr;
+		return ExecRunInterpretedExpr(state, econtext, isNull);
+	}
+
+	return ExecSwitchToCompiledExpr(state, econtext, isNull);
+}
+
+/*
+ * Evaluate expression using the interpreter, until it has been evaluated
+ * jit_tier_up_calls times.  Then switch over to the emitted function.
+ *
+ * The interpreter doesn't look at evalfunc_private (only
+ * ExecInterpExprStillValid does, and we've already done its checks), so
+ * it's OK for that to point to our state.
+ */
+static Datum
+ExecRunInterpretedExpr(ExprState *state, ExprContext *econtext, bool *isNull)
+{
+	CompiledExprState *cstate = state->evalfunc_private;
+
+	if (cstate->interp_calls_left > 0)
+	{
+		cstate->interp_calls_left--;
+		return cstate->interp_func(state, econtext, isNull);
+	}
+
+	return ExecSwitchToCompiledExpr(state, econtext, isNull);
+}
+
+/*
+ * Get a pointer to the emitted function, and use it from now on.  The
+ * latter can be the first thing that triggers optimizing and emitting all
+ * the generated functions.
+ */
+static Datum
+ExecSwitchToCompiledExpr(ExprState *state, ExprContext *econtext, bool *isNull)
+{
+	CompiledExprState *cstate = state->evalfunc_private;
+	ExprStateEvalFunc func;
+
 	llvm_enter_fatal_on_oom();
 	func = (ExprStateEvalFunc) llvm_get_function(cstate->context,
 												 cstate->funcname);
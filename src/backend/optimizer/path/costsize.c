@@ -78,6 +78,7 @@
 #include "access/tsmapi.h"
 #include "executor/executor.h"
 #include "executor/nodeHash.h"
+#include "executor/nodeResultCache.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
@@ -127,9 +128,11 @@ bool		enable_indexonlyscan = true;
 bool		enable_bitmapscan = true;
 bool		enable_tidscan = true;
 bool		enable_sort = true;
+bool		enable_incremental_sort = true;
 bool		enable_hashagg = true;
 bool		enable_nestloop = true;
 bool		enable_material = true;
+bool		enable_resultcache = false;
 bool		enable_mergejoin = true;
 bool		enable_hashjoin = true;
 bool		enable_gathermerge = true;
@@ -151,6 +154,13 @@ static MergeScanSelCache *cached_scansel(PlannerInfo *root,
 										 PathKey *pathkey);
 static void cost_rescan(PlannerInfo *root, Path *path,
 						Cost *rescan_startup_cost, Cost *rescan_total_cost);
+static void cost_resultcache_rescan(PlannerInfo *root, ResultCachePath *rcpath,
+									Cost *rescan_startup_cost,
+									Cost *rescan_total_cost);
+static void cost_tuplesort(Cost *startup_cost, Cost *run_cost,
+						   double tuples, int width,
+						   Cost comparison_cost, int sort_mem,
+						   double limit_tuples);
 static bool cost_qual_eval_walker(Node *node, cost_qual_eval_context *context);
 static void get_restriction_qual_cost(PlannerInfo *root, RelOptInfo *baserel,
 									  ParamPathInfo *param_info,
@@ -1695,17 +1705,39 @@ cost_sort(Path *path, PlannerInfo *root,
 		  Cost comparison_cost, int sort_mem,
 		  double limit_tuples)
 {
-	Cost		startup_cost = input_cost;
-	Cost		run_cost = 0;
-	double		input_bytes = relation_byte_size(tuples, width);
-	double		output_bytes;
-	double		output_tuples;
-	long		sort_mem_bytes = sort_mem * 1024L;
+	Cost		startup_cost;
+	Cost		run_cost;
+
+	cost_tuplesort(&startup_cost, &run_cost,
+				   tuples, width,
+				   comparison_cost, sort_mem,
+				   limit_tuples);
 
 	if (!enable_sort)
 		startup_cost += disable_cost;
 
+	startup_cost += input_cost;
+
 	path->rows = tuples;
+	path->startup_cost = startup_cost;
+	path->total_cost = startup_cost + run_cost;
+}
+
+/*
+ * cost_tuplesort
+ *	  Determines the cost of sorting with tuplesort, not including the cost
+ *	  of reading the input data; see cost_sort for the model and arguments.
+ */
+static void
+cost_tuplesort(Cost *startup_cost, Cost *run_cost,
+			   double tuples, int width,
+			   Cost comparison_cost, int sort_mem,
+			   double limit_tuples)
+{
+	double		input_bytes = relation_byte_size(tuples, width);
+	double		output_bytes;
+	double		output_tuples;
+	long		sort_mem_bytes = sort_mem * 1024L;
 
 	/*
 	 * We want to be sure the cost of a sort is never estimated as zero, even
@@ -1745,7 +1777,7 @@ cost_sort(Path *path, PlannerInfo *root,
 		 *
 		 * Assume about N log2 N comparisons
 		 */
-		startup_cost += comparison_cost * tuples * LOG2(tuples);
+		*startup_cost = comparison_cost * tuples * LOG2(tuples);
 
 		/* Disk costs */
 
@@ -1756,7 +1788,7 @@ cost_sort(Path *path, PlannerInfo *root,
 			log_runs = 1.0;
 		npageaccesses = 2.0 * npages * log_runs;
 		/* Assume 3/4ths of accesses are sequential, 1/4th are not */
-		startup_cost += npageaccesses *
+		*startup_cost += npageaccesses *
 			(seq_page_cost * 0.75 + random_page_cost * 0.25);
 	}
 	else if (tuples > 2 * output_tuples || input_bytes > sort_mem_bytes)
@@ -1767,12 +1799,12 @@ cost_sort(Path *path, PlannerInfo *root,
 		 * factor is a bit higher than for quicksort.  Tweak it so that the
 		 * cost curve is continuous at the crossover point.
 		 */
-		startup_cost += comparison_cost * tuples * LOG2(2.0 * output_tuples);
+		*startup_cost = comparison_cost * tuples * LOG2(2.0 * output_tuples);
 	}
 	else
 	{
 		/* We'll use plain quicksort on all the input tuples */
-		startup_cost += comparison_cost * tuples * LOG2(tuples);
+		*startup_cost = comparison_cost * tuples * LOG2(tuples);
 	}
 
 	/*
@@ -1783,8 +1815,118 @@ cost_sort(Path *path, PlannerInfo *root,
 	 * here --- the upper LIMIT will pro-rate the run cost so we'd be double
 	 * counting the LIMIT otherwise.
 	 */
-	run_cost += cpu_operator_cost * tuples;
+	*run_cost = cpu_operator_cost * tuples;
+}
+
+/*
+ * cost_incremental_sort
+ *	  Determines and returns the cost of sorting a relation incrementally,
+ *	  when the input path is already sorted by some of the pathkeys.
+ *
+ * 'presorted_keys' is the number of leading pathkeys by which the input path
+ * is sorted.
+ *
+ * We estimate the number of groups into which the relation is divided by the
+ * leading pathkeys, and then calculate the cost of sorting a single group
+ * with tuplesort using cost_tuplesort().  The other arguments are as for
+ * cost_sort, except that the input cost is split in startup and total cost,
+ * as only part of the input has to be read before the first output tuple.
+ */
+void
+cost_incremental_sort(Path *path,
+					  PlannerInfo *root, List *pathkeys, int presorted_keys,
+					  Cost input_startup_cost, Cost input_total_cost,
+					  double input_tuples, int width, Cost comparison_cost,
+					  int sort_mem, double limit_tuples)
+{
+	Cost		startup_cost;
+	Cost		run_cost;
+	Cost		input_run_cost = input_total_cost - input_startup_cost;
+	Cost		group_startup_cost;
+	Cost		group_run_cost;
+	Cost		group_input_run_cost;
+	double		group_tuples;
+	double		input_groups;
+	List	   *presortedExprs = NIL;
+	ListCell   *l;
+	int			i = 0;
+	bool		unknown_varno = false;
+
+	Assert(presorted_keys > 0);
+
+	/*
+	 * We want to be sure the cost of a sort is never estimated as zero, even
+	 * if passed-in tuple count is zero.  Besides, mustn't do log(0)...
+	 */
+	if (input_tuples < 2.0)
+		input_tuples = 2.0;
+
+	/* Default estimate of number of groups, capped to one group per row. */
+	input_groups = Min(input_tuples, DEFAULT_NUM_DISTINCT);
+
+	/*
+	 * Extract the presorted keys as a list of expressions.  Vars with varno 0,
+	 * as generate_append_tlist produces for set operations, would confuse
+	 * estimate_num_groups; just use the default estimate in that case.
+	 */
+	foreach(l, pathkeys)
+	{
+		PathKey    *key = (PathKey *) lfirst(l);
+		EquivalenceMember *member = (EquivalenceMember *)
+		linitial(key->pk_eclass->ec_members);
+
+		if (bms_is_member(0, pull_varnos((Node *) member->em_expr)))
+		{
+			unknown_varno = true;
+			break;
+		}
+
+		presortedExprs = lappend(presortedExprs, member->em_expr);
+
+		if (++i >= presorted_keys)
+			break;
+	}
+
+	/* Estimate number of groups with equal presorted keys. */
+	if (!unknown_varno)
+		input_groups = estimate_num_groups(root, presortedExprs, input_tuples,
+										   NULL);
+
+	group_tuples = input_tuples / input_groups;
+	group_input_run_cost = input_run_cost / input_groups;
+
+	/*
+	 * Estimate the cost of sorting one group.  The tuples are seldom spread
+	 * evenly over the groups, so be pessimistic and assume groups half again
+	 * as large as the average.
+	 */
+	cost_tuplesort(&group_startup_cost, &group_run_cost,
+				   1.5 * group_tuples, width, comparison_cost, sort_mem,
+				   limit_tuples);
+
+	/*
+	 * The first output tuple is available after reading and sorting the
+	 * first group.
+	 */
+	startup_cost = input_startup_cost + group_input_run_cost +
+		group_startup_cost;
+
+	/*
+	 * Then we have to finish the first group, and read and sort each of the
+	 * remaining groups.
+	 */
+	run_cost = group_run_cost +
+		(group_run_cost + group_startup_cost) * (input_groups - 1) +
+		group_input_run_cost * (input_groups - 1);
+
+	/*
+	 * Detecting group boundaries takes about one tuple copy and comparison
+	 * per tuple, and every group needs a fresh tuplesort.
+	 */
+	run_cost += (cpu_tuple_cost + comparison_cost) * input_tuples;
+	run_cost += 2.0 * cpu_tuple_cost * input_groups;
 
+	path->rows = input_tuples;
 	path->startup_cost = startup_cost;
 	path->total_cost = startup_cost + run_cost;
 }
@@ -2136,6 +2278,85 @@ cost_material(Path *path,
 	path->total_cost = startup_cost + run_cost;
 }
 
+/*
+ * cost_resultcache_rescan
+ *	  Determines the estimated cost of rescanning a ResultCache node.
+ *
+ * The first scan of the node is costed by create_resultcache_path; here we
+ * estimate how often a rescan will find its parameter values in the cache,
+ * based on the number of distinct values expected and on how many entries
+ * fit in work_mem, and charge the subpath's cost only for the misses.
+ *
+ * As a side effect, this sets rcpath->est_entries, which the executor uses
+ * to size the hash table.
+ */
+static void
+cost_resultcache_rescan(PlannerInfo *root, ResultCachePath *rcpath,
+						Cost *rescan_startup_cost, Cost *rescan_total_cost)
+{
+	Cost		input_startup_cost = rcpath->subpath->startup_cost;
+	Cost		input_total_cost = rcpath->subpath->total_cost;
+	double		tuples = rcpath->subpath->rows;
+	double		calls = Max(rcpath->calls, 1.0);
+	int			width = rcpath->subpath->pathtarget->width;
+	double		work_mem_bytes = work_mem * 1024.0;
+	double		est_entry_bytes;
+	double		est_cache_entries;
+	double		ndistinct;
+	double		evict_ratio;
+	double		hit_ratio;
+	Cost		startup_cost;
+	Cost		total_cost;
+
+	/* the tuples of an entry, plus the executor's overhead for it */
+	est_entry_bytes = relation_byte_size(tuples, width) +
+		ExecEstimateCacheEntryOverheadBytes(tuples);
+
+	/* how many entries fit in the cache at once */
+	est_cache_entries = Max(floor(work_mem_bytes / est_entry_bytes), 1.0);
+
+	/* how many distinct parameter values we'll be called with */
+	ndistinct = estimate_num_groups(root, rcpath->param_exprs, calls, NULL);
+
+	rcpath->est_entries = (uint32) Min(Min(ndistinct, est_cache_entries),
+									   PG_UINT32_MAX);
+
+	/*
+	 * If not all the distinct values fit in the cache, entries have to be
+	 * evicted to make room for new ones.
+	 */
+	evict_ratio = 1.0 - Min(est_cache_entries, ndistinct) / ndistinct;
+
+	/*
+	 * Each distinct value misses the first time it is seen, and then hits as
+	 * long as its entry stays in the cache.
+	 */
+	hit_ratio = ((calls - ndistinct) / calls) *
+		(Min(est_cache_entries, ndistinct) / ndistinct);
+	hit_ratio = Max(hit_ratio, 0.0);
+
+	/*
+	 * Charge the subpath for the misses, plus a cpu_operator_cost for the
+	 * lookup.
+	 */
+	total_cost = input_total_cost * (1.0 - hit_ratio) + cpu_operator_cost;
+
+	/*
+	 * Charge a cpu_tuple_cost for evicting an entry, and a tenth of
+	 * cpu_operator_cost for freeing each of its tuples.
+	 */
+	total_cost += cpu_tuple_cost * evict_ratio;
+	total_cost += cpu_operator_cost / 10.0 * evict_ratio * tuples;
+
+	/* Charge for creating the entry and storing the tuples into it */
+	total_cost += cpu_tuple_cost + cpu_operator_cost * tuples;
+
+	startup_cost = input_startup_cost * (1.0 - hit_ratio) + cpu_tuple_cost;
+
+	*rescan_startup_cost = startup_cost;
+	*rescan_total_cost = total_cost;
+}
+
 /*
  * cost_agg
  *		Determines and returns the cost of performing an Agg plan node,
@@ -3800,6 +4021,11 @@ cost_rescan(PlannerInfo *root, Path *path,
 				*rescan_total_cost = run_cost;
 			}
 			break;
+		case T_ResultCache:
+			/* A cache hit avoids rescanning the subpath altogether */
+			cost_resultcache_rescan(root, (ResultCachePath *) path,
+									rescan_startup_cost, rescan_total_cost);
+			break;
 		default:
 			*rescan_startup_cost = path->startup_cost;
 			*rescan_total_cost = path->total_cost;
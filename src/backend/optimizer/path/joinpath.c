@@ -18,10 +18,13 @@
 
 #include "executor/executor.h"
 #include "foreign/fdwapi.h"
+#include "nodes/nodeFuncs.h"
 #include "optimizer/cost.h"
+#include "optimizer/optimizer.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
 #include "optimizer/planmain.h"
+#include "utils/lsyscache.h"
 
 /* Hook for plugins to get control in add_paths_to_joinrel() */
 set_join_pathlist_hook_type set_join_pathlist_hook = NULL;
@@ -866,6 +869,155 @@ clause_sides_match_join(RestrictInfo *rinfo, RelOptInfo *outerrel,
 	return false;				/* no good for these input relations */
 }
 
+/*
+ * paraminfo_get_equal_hashops
+ *	  Determine the cache keys for caching the results of a parameterized
+ *	  path: the outer sides of the join clauses it is parameterized with.
+ *
+ * Returns false if they can't serve as cache keys.  Otherwise sets
+ * *param_exprs to the key expressions and *operators to the hash equality
+ * operators to compare them with.
+ */
+static bool
+paraminfo_get_equal_hashops(ParamPathInfo *param_info,
+							RelOptInfo *outerrel, RelOptInfo *innerrel,
+							List **param_exprs, List **operators)
+{
+	ListCell   *lc;
+
+	*param_exprs = NIL;
+	*operators = NIL;
+
+	foreach(lc, param_info->ppi_clauses)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+		OpExpr	   *opexpr;
+		Expr	   *expr;
+		Oid			eqop = InvalidOid;
+
+		/* we need "outerrel_expr op innerrel_expr" or the reverse */
+		if (!is_opclause(rinfo->clause) ||
+			list_length(((OpExpr *) rinfo->clause)->args) != 2 ||
+			bms_is_empty(rinfo->left_relids) ||
+			bms_is_empty(rinfo->right_relids) ||
+			!clause_sides_match_join(rinfo, outerrel, innerrel))
+			return false;
+
+		opexpr = (OpExpr *) rinfo->clause;
+		if (rinfo->outer_is_left)
+			expr = (Expr *) linitial(opexpr->args);
+		else
+			expr = (Expr *) lsecond(opexpr->args);
+
+		if (contain_volatile_functions((Node *) expr))
+			return false;
+
+		/*
+		 * Compare the key values using the join operator's own notion of
+		 * equality, not the type's default one: find the hash equality
+		 * operator for the outer side's type in the same opfamily as the
+		 * clause's operator.  If the clause isn't hashjoinable we can't
+		 * cache on it.
+		 */
+		if (!op_hashjoinable(opexpr->opno,
+							 exprType((Node *) linitial(opexpr->args))))
+			return false;
+		if (!get_compatible_hash_operators(opexpr->opno,
+										   rinfo->outer_is_left ? &eqop : NULL,
+										   rinfo->outer_is_left ? NULL : &eqop) ||
+			!OidIsValid(eqop))
+			return false;
+
+		*param_exprs = lappend(*param_exprs, expr);
+		*operators = lappend_oid(*operators, eqop);
+	}
+
+	return *param_exprs != NIL;
+}
+
+/*
+ * get_resultcache_path
+ *	  If possible, make a ResultCachePath caching the results of
+ *	  'inner_path' for the nested loop join of 'outer_path' and 'inner_path'.
+ *
+ * Returns NULL if a cache can't be used, or isn't worth considering.
+ */
+static Path *
+get_resultcache_path(PlannerInfo *root, RelOptInfo *innerrel,
+					 RelOptInfo *outerrel, Path *inner_path,
+					 Path *outer_path, JoinType jointype,
+					 JoinPathExtraData *extra)
+{
+	List	   *param_exprs;
+	List	   *hash_operators;
+	ListCell   *lc;
+
+	if (!enable_resultcache)
+		return NULL;
+
+	/* A cache only helps if we expect the inner side to be rescanned */
+	if (outer_path->parent->rows < 2)
+		return NULL;
+
+	/* Without parameters, every scan returns the same; use Material for that */
+	if (inner_path->param_info == NULL ||
+		inner_path->param_info->ppi_clauses == NIL)
+		return NULL;
+
+	/*
+	 * For now, we only cache scans of plain tables without lateral
+	 * references, whose results depend on nothing but the join clauses in
+	 * their parameterization.
+	 */
+	if ((innerrel->reloptkind != RELOPT_BASEREL &&
+		 innerrel->reloptkind != RELOPT_OTHER_MEMBER_REL) ||
+		innerrel->rtekind != RTE_RELATION ||
+		!bms_is_empty(innerrel->lateral_relids))
+		return NULL;
+
+	/*
+	 * Volatile functions in the scan must be evaluated for every outer row,
+	 * so we can't skip any scans.
+	 */
+	if (contain_volatile_functions((Node *) innerrel->reltarget->exprs))
+		return NULL;
+	foreach(lc, innerrel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+		if (contain_volatile_functions((Node *) rinfo->clause))
+			return NULL;
+	}
+
+	/*
+	 * Cache entries can only be used once their scan has been read to the
+	 * end, but the nested loop stops reading the inner side after the first
+	 * match for semi and anti joins, and when the inner side is unique.  In
+	 * the unique case, if all the join clauses are in the parameterization,
+	 * each scan returns at most one row, so an entry can be marked complete
+	 * after its first row.  Otherwise, don't bother.
+	 */
+	if (!extra->inner_unique &&
+		(jointype == JOIN_SEMI || jointype == JOIN_ANTI))
+		return NULL;
+	if (extra->inner_unique &&
+		list_length(inner_path->param_info->ppi_clauses) <
+		list_length(extra->restrictlist))
+		return NULL;
+
+	if (!paraminfo_get_equal_hashops(inner_path->param_info, outerrel,
+									 innerrel, &param_exprs, &hash_operators))
+		return NULL;
+
+	return (Path *) create_resultcache_path(root,
+											innerrel,
+											inner_path,
+											param_exprs,
+											hash_operators,
+											extra->inner_unique,
+											outer_path->parent->rows);
+}
+
 /*
  * sort_inner_and_outer
  *	  Create mergejoin join paths by explicitly sorting both the outer and
@@ -1471,6 +1623,7 @@ match_unsorted_outer(PlannerInfo *root,
 			foreach(lc2, innerrel->cheapest_parameterized_paths)
 			{
 				Path	   *innerpath = (Path *) lfirst(lc2);
+				Path	   *rcpath;
 
 				try_nestloop_path(root,
 								  joinrel,
@@ -1479,6 +1632,22 @@ match_unsorted_outer(PlannerInfo *root,
 								  merge_pathkeys,
 								  jointype,
 								  extra);
+
+				/*
+				 * Also try caching the results of the inner path, in case
+				 * the outer side repeats the parameter values.
+				 */
+				rcpath = get_resultcache_path(root, innerrel, outerrel,
+											  innerpath, outerpath, jointype,
+											  extra);
+				if (rcpath != NULL)
+					try_nestloop_path(root,
+									  joinrel,
+									  outerpath,
+									  rcpath,
+									  merge_pathkeys,
+									  jointype,
+									  extra);
 			}
 
 			/* Also consider materialized form of the cheapest inner path */
@@ -4962,13 +4962,17 @@ create_ordered_paths(PlannerInfo *root,
 
 	foreach(lc, input_rel->pathlist)
 	{
-		Path	   *path = (Path *) lfirst(lc);
+		Path	   *input_path = (Path *) lfirst(lc);
+		Path	   *path;
 		bool		is_sorted;
+		int			presorted_keys;
 
-		is_sorted = pathkeys_contained_in(root->sort_pathkeys,
-										  path->pathkeys);
-		if (path == cheapest_input_path || is_sorted)
+		is_sorted = pathkeys_count_contained_in(root->sort_pathkeys,
+												input_path->pathkeys,
+												&presorted_keys);
+		if (input_path == cheapest_input_path || is_sorted)
 		{
+			path = input_path;
 			if (!is_sorted)
 			{
 				/* An explicit sort here can take advantage of LIMIT */
@@ -4986,6 +4990,30 @@ create_ordered_paths(PlannerInfo *root,
 
 			add_path(ordered_rel, path);
 		}
+
+		/*
+		 * If the path is sorted by a prefix of the required keys, consider
+		 * sorting just the groups of equal prefix.  This pays off under a
+		 * LIMIT, when only the first groups of the input need to be read;
+		 * without one, a full sort of the cheapest path is rarely worse.
+		 */
+		if (!is_sorted && presorted_keys > 0 &&
+			enable_incremental_sort && limit_tuples >= 0)
+		{
+			path = (Path *) create_incremental_sort_path(root,
+														 ordered_rel,
+														 input_path,
+														 root->sort_pathkeys,
+														 presorted_keys,
+														 limit_tuples);
+
+			/* Add projection step if needed */
+			if (path->pathtarget != target)
+				path = apply_projection_to_path(root, ordered_rel,
+												path, target);
+
+			add_path(ordered_rel, path);
+		}
 	}
 
 	/*
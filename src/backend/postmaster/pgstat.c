@@ -2641,6 +2641,7 @@ pgstat_fetch_global(void)
 
 static PgBackendStatus *BackendStatusArray = NULL;
 static PgBackendStatus *MyBEEntry = NULL;
+pg_atomic_uint64 *my_mem_allocated = NULL;
 static char *BackendAppnameBuffer = NULL;
 static char *BackendClientHostnameBuffer = NULL;
 static char *BackendActivityBuffer = NULL;
@@ -2708,6 +2709,8 @@ CreateSharedBackendStatus(void)
 		 * We're the first - initialize.
 		 */
 		MemSet(BackendStatusArray, 0, size);
+		for (i = 0; i < NumBackendStatSlots; i++)
+			pg_atomic_init_u64(&BackendStatusArray[i].st_mem_allocated, 0);
 	}
 
 	/* Create or attach to the shared appname buffer */
@@ -3079,6 +3082,10 @@ pgstat_bestart(void)
 
 	PGSTAT_END_WRITE_ACTIVITY(vbeentry);
 
+	/* Start publishing how much memory our contexts hold */
+	pg_atomic_write_u64(&MyBEEntry->st_mem_allocated, BackendMemoryAllocated);
+	my_mem_allocated = &MyBEEntry->st_mem_allocated;
+
 	/* Update app name to current GUC setting */
 	if (application_name)
 		pgstat_report_appname(application_name);
@@ -3107,6 +3114,10 @@ pgstat_beshutdown_hook(int code, Datum arg)
 	if (OidIsValid(MyDatabaseId))
 		pgstat_report_stat(true);
 
+	/* Stop publishing memory usage into the entry we're giving up */
+	my_mem_allocated = NULL;
+	pg_atomic_write_u64(&beentry->st_mem_allocated, 0);
+
 	/*
 	 * Clear my status entry, following the protocol of bumping st_changecount
 	 * before and after.  We use a volatile pointer here to ensure the
@@ -3480,6 +3491,10 @@ pgstat_read_current_status(void)
 			CHECK_FOR_INTERRUPTS();
 		}
 
+		/* This one isn't covered by st_changecount, see PgBackendStatus */
+		localentry->backend_mem_allocated =
+			pg_atomic_read_u64(&beentry->st_mem_allocated);
+
 		beentry++;
 		/* Only valid entries get included into the local array */
 		if (localentry->backendStatus.st_procpid > 0)
@@ -16,11 +16,15 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <time.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 #include "access/xlog_internal.h"	/* for pg_start/stop_backup */
 #include "catalog/pg_class.h"
 #include "catalog/pg_control.h"
 #include "catalog/pg_type.h"
+#include "commands/sequence.h"
 #include "common/controldata_utils.h"
 #include "common/file_perm.h"
 #include "lib/stringinfo.h"
@@ -56,6 +60,8 @@ typedef struct
 	bool		includewal;
 	uint32		maxrate;
 	bool		sendtblspcmapfile;
+	XLogRecPtr	incremental_lsn;
+	int			compression_level;
 } basebackup_options;
 
 
@@ -63,7 +69,18 @@ static int64 sendDir(const char *path, int basepathlen, bool sizeonly,
 					 List *tablespaces, bool sendtblspclinks);
 static bool sendFile(const char *readfilename, const char *tarfilename,
 					 struct stat *statbuf, bool missing_ok, Oid dboid);
+static bool sendIncrementalFile(const char *readfilename,
+								const char *tarfilename,
+								struct stat *statbuf, bool missing_ok,
+								Oid dboid);
 static void sendFileWithContent(const char *filename, const char *content);
+static void sendData(const char *data, size_t len);
+static void sendCopyDone(void);
+#ifdef HAVE_LIBZ
+static voidpf zlib_palloc(voidpf opaque, uInt items, uInt size);
+static void zlib_pfree(voidpf opaque, voidpf address);
+static void deflateAndSend(int flush);
+#endif
 static void sendFileWithContentGeneric(const char *filename,
 									   const char *content,
 									   size_t len, struct stat *statbuf);
@@ -79,6 +96,7 @@ static void SendXlogRecPtrResult(XLogRecPtr ptr, TimeLineID tli);
 static int	compareWalFileNames(const void *a, const void *b);
 static void throttle(size_t increment);
 static bool is_checksummed_file(const char *fullpath, const char *filename);
+static bool is_incremental_file(const char *fullpath, const char *filename);
 
 /* Was the backup currently in-progress initiated in recovery mode? */
 static bool backup_started_in_recovery = false;
@@ -129,6 +147,21 @@ static int64 total_checksum_failures;
 /* Do not verify checksums. */
 static bool noverify_checksums = false;
 
+/*
+ * For an incremental backup, the start LSN of the reference backup.  Blocks
+ * of relation files whose LSN is older are not sent.
+ */
+static XLogRecPtr incremental_lsn = InvalidXLogRecPtr;
+
+#ifdef HAVE_LIBZ
+/*
+ * If the client asked for compression, the tar stream of each tablespace is
+ * sent as a gzip stream, produced by zstream into zbuf.
+ */
+static z_stream *zstream = NULL;
+static char *zbuf = NULL;
+#endif
+
 /*
  * Definition of one element part of an exclusion list, used for paths part
  * of checksum validation or base backups.  "name" is the name of the file
@@ -288,6 +321,28 @@ perform_base_backup(basebackup_options *opt)
 		ListCell   *lc;
 		tablespaceinfo *ti;
 
+		/*
+		 * For an incremental backup, the reference backup must have been
+		 * taken earlier.  Also record the reference LSN in the backup label,
+		 * so that the chain of backups can be verified when combining them.
+		 */
+		incremental_lsn = opt->incremental_lsn;
+		if (!XLogRecPtrIsInvalid(incremental_lsn))
+		{
+			if (incremental_lsn > startptr)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("incremental backup reference LSN %X/%X is newer than the backup start LSN %X/%X",
+								(uint32) (incremental_lsn >> 32),
+								(uint32) incremental_lsn,
+								(uint32) (startptr >> 32),
+								(uint32) startptr)));
+
+			appendStringInfo(labelfile, "INCREMENTAL FROM LSN: %X/%X\n",
+							 (uint32) (incremental_lsn >> 32),
+							 (uint32) incremental_lsn);
+		}
+
 		SendXlogRecPtrResult(startptr, starttli);
 
 		/*
@@ -334,6 +389,25 @@ perform_base_backup(basebackup_options *opt)
 			throttling_counter = -1;
 		}
 
+#ifdef HAVE_LIBZ
+		/* Set up compression of the tar streams, if requested. */
+		zstream = NULL;
+		if (opt->compression_level > 0)
+		{
+			zstream = palloc0(sizeof(z_stream));
+			zstream->zalloc = zlib_palloc;
+			zstream->zfree = zlib_pfree;
+			zbuf = palloc(TAR_SEND_SIZE);
+
+			/* 15 + 16 selects the gzip format, so that the output is a .tar.gz */
+			if (deflateInit2(zstream, opt->compression_level, Z_DEFLATED,
+							 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				ereport(ERROR,
+						(errmsg("could not initialize compression library: %s",
+								zstream->msg)));
+		}
+#endif
+
 		/* Send off our tablespaces one by one */
 		foreach(lc, tablespaces)
 		{
@@ -414,7 +488,7 @@ perform_base_backup(basebackup_options *opt)
 				Assert(lnext(lc) == NULL);
 			}
 			else
-				pq_putemptymessage('c');	/* CopyDone */
+				sendCopyDone();
 		}
 
 		endptr = do_pg_stop_backup(labelfile->data, !opt->nowait, &endtli);
@@ -628,9 +702,7 @@ perform_base_backup(basebackup_options *opt)
 				}
 
 				/* Send the chunk as a CopyData message */
-				if (pq_putmessage('d', buf, cnt))
-					ereport(ERROR,
-							(errmsg("base backup could not send data, aborting backup")));
+				sendData(buf, cnt);
 
 				len += cnt;
 				throttle(cnt);
@@ -691,7 +763,7 @@ perform_base_backup(basebackup_options *opt)
 		}
 
 		/* Send CopyDone message for the last tar file */
-		pq_putemptymessage('c');
+		sendCopyDone();
 	}
 	SendXlogRecPtrResult(endptr, endtli);
 
@@ -711,6 +783,15 @@ perform_base_backup(basebackup_options *opt)
 				 errmsg("checksum verification failure during base backup")));
 	}
 
+#ifdef HAVE_LIBZ
+	if (zstream != NULL)
+	{
+		deflateEnd(zstream);
+		pfree(zstream);
+		pfree(zbuf);
+		zstream = NULL;
+	}
+#endif
 }
 
 /*
@@ -742,8 +823,11 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 	bool		o_tablespace_map = false;
 	bool		o_noverify_checksums = false;
 	bool		o_decrypt = false;
+	bool		o_incremental = false;
+	bool		o_compression = false;
 
 	MemSet(opt, 0, sizeof(*opt));
+	opt->incremental_lsn = InvalidXLogRecPtr;
 	foreach(lopt, options)
 	{
 		DefElem    *defel = (DefElem *) lfirst(lopt);
@@ -839,6 +923,49 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 			decrypt = true;
 			o_decrypt = true;
 		}
+		else if (strcmp(defel->defname, "incremental") == 0)
+		{
+			char	   *lsnstr = strVal(defel->arg);
+			uint32		hi,
+						lo;
+
+			if (o_incremental)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+
+			if (sscanf(lsnstr, "%X/%X", &hi, &lo) != 2 ||
+				(((uint64) hi) << 32 | lo) == InvalidXLogRecPtr)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("invalid value for parameter \"%s\": \"%s\"",
+								"INCREMENTAL", lsnstr)));
+
+			opt->incremental_lsn = ((uint64) hi) << 32 | lo;
+			o_incremental = true;
+		}
+		else if (strcmp(defel->defname, "compression") == 0)
+		{
+			int			level = intVal(defel->arg);
+
+			if (o_compression)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+#ifndef HAVE_LIBZ
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("compression is not supported by this build")));
+#endif
+			if (level < 0 || level > 9)
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						 errmsg("%d is outside the valid range for parameter \"%s\" (%d .. %d)",
+								level, "COMPRESSION", 0, 9)));
+
+			opt->compression_level = level;
+			o_compression = true;
+		}
 		else
 			elog(ERROR, "option \"%s\" not recognized",
 				 defel->defname);
@@ -1040,6 +1167,100 @@ sendFileWithContent(const char *filename, const char *content)
 	sendFileWithContentGeneric(filename, content, 0, &statbuf);
 }
 
+#ifdef HAVE_LIBZ
+/*
+ * Memory allocation callbacks for zlib, so that its state goes away with the
+ * memory context if the backup fails.
+ */
+static voidpf
+zlib_palloc(voidpf opaque, uInt items, uInt size)
+{
+	return palloc((Size) items * size);
+}
+
+static void
+zlib_pfree(voidpf opaque, voidpf address)
+{
+	pfree(address);
+}
+
+/*
+ * Run the compressor over the pending input, sending out every full output
+ * buffer, and the remaining output too if 'flush' is Z_FINISH.
+ */
+static void
+deflateAndSend(int flush)
+{
+	int			rc;
+
+	do
+	{
+		zstream->next_out = (Bytef *) zbuf;
+		zstream->avail_out = TAR_SEND_SIZE;
+
+		rc = deflate(zstream, flush);
+		if (rc == Z_STREAM_ERROR)
+			ereport(ERROR,
+					(errmsg("could not compress data: %s", zstream->msg)));
+
+		if (zstream->avail_out < TAR_SEND_SIZE &&
+			pq_putmessage('d', zbuf, TAR_SEND_SIZE - zstream->avail_out))
+			ereport(ERROR,
+					(errmsg("base backup could not send data, aborting backup")));
+	} while (zstream->avail_out == 0 ||
+			 (flush == Z_FINISH && rc != Z_STREAM_END));
+}
+#endif
+
+/*
+ * Send a piece of the current tar stream as CopyData, compressing it first
+ * if requested.
+ */
+static void
+sendData(const char *data, size_t len)
+{
+	if (len == 0)
+		return;
+
+#ifdef HAVE_LIBZ
+	if (zstream != NULL)
+	{
+		zstream->next_in = (Bytef *) data;
+		zstream->avail_in = len;
+		deflateAndSend(Z_NO_FLUSH);
+		Assert(zstream->avail_in == 0);
+		return;
+	}
+#endif
+
+	if (pq_putmessage('d', data, len))
+		ereport(ERROR,
+				(errmsg("base backup could not send data, aborting backup")));
+}
+
+/*
+ * End the current tar stream: flush the compressor, if any, and send
+ * CopyDone.
+ */
+static void
+sendCopyDone(void)
+{
+#ifdef HAVE_LIBZ
+	if (zstream != NULL)
+	{
+		zstream->next_in = NULL;
+		zstream->avail_in = 0;
+		deflateAndSend(Z_FINISH);
+		if (deflateReset(zstream) != Z_OK)
+			ereport(ERROR,
+					(errmsg("could not reset compression stream: %s",
+							zstream->msg)));
+	}
+#endif
+
+	pq_putemptymessage('c');
+}
+
 /*
  * Inject a file with given name and content in the output tar stream.
  *
@@ -1056,7 +1277,7 @@ sendFileWithContentGeneric(const char *filename, const char *content,
 
 	_tarWriteHeader(filename, NULL, statbuf, false);
 	/* Send the contents as a CopyData message */
-	pq_putmessage('d', content, len);
+	sendData(content, len);
 
 	/* Pad to 512 byte boundary, per tar format requirements */
 	pad = ((len + 511) & ~511) - len;
@@ -1065,7 +1286,7 @@ sendFileWithContentGeneric(const char *filename, const char *content,
 		char		buf[512];
 
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		sendData(buf, pad);
 	}
 }
 
@@ -1435,8 +1656,18 @@ sendDir(const char *path, int basepathlen, bool sizeonly, List *tablespaces,
 			bool		sent = false;
 
 			if (!sizeonly)
-				sent = sendFile(pathbuf, pathbuf + basepathlen + 1, &statbuf,
-								true, isDbDir ? atooid(lastDir + 1) : InvalidOid);
+			{
+				if (!XLogRecPtrIsInvalid(incremental_lsn) &&
+					is_incremental_file(pathbuf, de->d_name))
+					sent = sendIncrementalFile(pathbuf,
+											   pathbuf + basepathlen + 1,
+											   &statbuf, true,
+											   isDbDir ? atooid(lastDir + 1) : InvalidOid);
+				else
+					sent = sendFile(pathbuf, pathbuf + basepathlen + 1,
+									&statbuf, true,
+									isDbDir ? atooid(lastDir + 1) : InvalidOid);
+			}
 
 			if (sent || sizeonly)
 			{
@@ -1487,6 +1718,75 @@ is_checksummed_file(const char *fullpath, const char *filename)
 		return false;
 }
 
+/*
+ * Check if a file may be sent incrementally: main fork segments of relations
+ * in regular tablespaces.  The free space map is not WAL-logged, and
+ * clearing a visibility map bit does not advance the page LSN, so the other
+ * forks are always sent in full; they are small anyway.
+ */
+static bool
+is_incremental_file(const char *fullpath, const char *filename)
+{
+	const char *p = filename;
+
+	if (!is_checksummed_file(fullpath, filename))
+		return false;
+
+	/* relfilenode, optionally followed by a segment number */
+	if (!isdigit((unsigned char) *p))
+		return false;
+	while (isdigit((unsigned char) *p))
+		p++;
+	if (*p == '.')
+	{
+		p++;
+		if (!isdigit((unsigned char) *p))
+			return false;
+		while (isdigit((unsigned char) *p))
+			p++;
+	}
+
+	return *p == '\0';
+}
+
+/*
+ * Does the given block need to be included in an incremental backup?
+ *
+ * A page whose LSN is older than the start of the reference backup has not
+ * been modified since.  A torn read cannot fool us: if the page is being
+ * written concurrently, it was modified after the start of this backup, and
+ * WAL replay will restore it from a full-page image.
+ */
+static inline bool
+block_is_changed(char *page)
+{
+	XLogRecPtr	lsn = PageGetLSN(page);
+
+	return XLogRecPtrIsInvalid(lsn) || lsn >= incremental_lsn;
+}
+
+/*
+ * Is this the (single) page of a sequence relation?  nextval() dirties the
+ * sequence page without writing WAL for every call, so the page LSN does not
+ * tell us whether it changed; such pages are always sent.
+ */
+static bool
+is_sequence_page(char *page, BlockNumber blkno)
+{
+	PGAlignedBlock copy;
+	sequence_magic *sm;
+
+	if (data_encrypted)
+	{
+		/* The special space is not readable in encrypted form. */
+		decrypt_page(page, copy.data, blkno, RELPERSISTENCE_PERMANENT);
+		page = copy.data;
+	}
+
+	sm = (sequence_magic *) (page + BLCKSZ - MAXALIGN(sizeof(sequence_magic)));
+	return sm->magic == SEQ_MAGIC;
+}
+
 /*****
  * Functions for handling tar file format
  *
@@ -1727,9 +2027,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 		}
 
 		/* Send the chunk as a CopyData message */
-		if (pq_putmessage('d', buf, cnt))
-			ereport(ERROR,
-					(errmsg("base backup could not send data, aborting backup")));
+		sendData(buf, cnt);
 
 		len += cnt;
 		throttle(cnt);
@@ -1754,7 +2052,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 		while (len < statbuf->st_size)
 		{
 			cnt = Min(sizeof(buf), statbuf->st_size - len);
-			pq_putmessage('d', buf, cnt);
+			sendData(buf, cnt);
 			len += cnt;
 			throttle(cnt);
 		}
@@ -1768,7 +2066,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 	if (pad > 0)
 	{
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		sendData(buf, pad);
 	}
 
 	FreeFile(fp);
@@ -1790,6 +2088,187 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 }
 
 
+/*
+ * Like sendFile(), but send only the blocks of a relation segment that were
+ * modified since incremental_lsn, as a file named INCREMENTAL_PREFIX followed
+ * by the segment's name.  See IncrementalFileHeader for the format.
+ */
+static bool
+sendIncrementalFile(const char *readfilename, const char *tarfilename,
+					struct stat *statbuf, bool missing_ok, Oid dboid)
+{
+	FILE	   *fp;
+	char		incrname[MAXPGPATH];
+	const char *lastsep;
+	struct stat incrstat;
+	IncrementalFileHeader hdr;
+	BlockNumber *changed;
+	BlockNumber nblocks;
+	BlockNumber nchanged = 0;
+	BlockNumber blkno;
+	PGAlignedBlock buf;
+	char	   *filename;
+	char	   *segmentpath;
+	int			segmentno = 0;
+	int			checksum_failures = 0;
+	pgoff_t		len;
+	size_t		pad;
+	bool		verify_checksum = !noverify_checksums && DataChecksumsEnabled();
+	bool		decrypt_file = decrypt && data_encrypted;
+
+	fp = AllocateFile(readfilename, "rb");
+	if (fp == NULL)
+	{
+		if (errno == ENOENT && missing_ok)
+			return false;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", readfilename)));
+	}
+
+	filename = last_dir_separator(readfilename) + 1;
+	segmentpath = strstr(filename, ".");
+	if (segmentpath != NULL)
+	{
+		segmentno = atoi(segmentpath + 1);
+		if (segmentno == 0)
+			ereport(ERROR,
+					(errmsg("invalid segment number %d in file \"%s\"",
+							segmentno, filename)));
+	}
+
+	/*
+	 * Any partial block at the end is being extended concurrently; WAL
+	 * replay takes care of it.
+	 */
+	nblocks = statbuf->st_size / BLCKSZ;
+
+	/* First pass: find the blocks to send. */
+	changed = palloc(Max(nblocks, 1) * sizeof(BlockNumber));
+	for (blkno = 0; blkno < nblocks; blkno++)
+	{
+		if (fread(buf.data, 1, BLCKSZ, fp) != BLCKSZ)
+		{
+			CHECK_FREAD_ERROR(fp, readfilename);
+			/* Truncated concurrently, WAL replay will truncate it too. */
+			nblocks = blkno;
+			break;
+		}
+
+		if (block_is_changed(buf.data) ||
+			(nblocks == 1 && segmentno == 0 && is_sequence_page(buf.data, 0)))
+			changed[nchanged++] = blkno;
+	}
+
+	/* Build the member name and size, and write the tar header. */
+	lastsep = last_dir_separator(tarfilename);
+	if (lastsep != NULL)
+		snprintf(incrname, sizeof(incrname), "%.*s%s%s",
+				 (int) (lastsep - tarfilename + 1), tarfilename,
+				 INCREMENTAL_PREFIX, lastsep + 1);
+	else
+		snprintf(incrname, sizeof(incrname), "%s%s",
+				 INCREMENTAL_PREFIX, tarfilename);
+
+	memcpy(&incrstat, statbuf, sizeof(struct stat));
+	incrstat.st_size = sizeof(IncrementalFileHeader) +
+		(pgoff_t) nchanged * (sizeof(BlockNumber) + BLCKSZ);
+
+	_tarWriteHeader(incrname, NULL, &incrstat, false);
+
+	hdr.magic = INCREMENTAL_MAGIC;
+	hdr.nblocks = nblocks;
+	hdr.nchanged = nchanged;
+	sendData((char *) &hdr, sizeof(hdr));
+	sendData((char *) changed, nchanged * sizeof(BlockNumber));
+	len = sizeof(hdr) + nchanged * sizeof(BlockNumber);
+
+	/* Second pass: send the blocks. */
+	for (blkno = 0; blkno < nchanged; blkno++)
+	{
+		BlockNumber blkno_global = changed[blkno] + segmentno * RELSEG_SIZE;
+		char	   *page = buf.data;
+
+		if (fseeko(fp, (pgoff_t) changed[blkno] * BLCKSZ, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not fseek in file \"%s\": %m",
+							readfilename)));
+
+		if (fread(page, 1, BLCKSZ, fp) != BLCKSZ)
+		{
+			CHECK_FREAD_ERROR(fp, readfilename);
+			/* Truncated concurrently, send zeroes like sendFile() does. */
+			MemSet(page, 0, BLCKSZ);
+		}
+		else if (verify_checksum && !PageIsNew(page) &&
+				 PageGetLSN(page) < startptr &&
+				 ((PageHeader) page)->pd_checksum !=
+				 pg_checksum_page(page, blkno_global))
+		{
+			/*
+			 * Unlike sendFile(), we don't retry torn reads here: a page that
+			 * was unmodified since the start of the backup can't be torn.
+			 */
+			checksum_failures++;
+
+			if (checksum_failures <= 5)
+				ereport(WARNING,
+						(errmsg("checksum verification failed in "
+								"file \"%s\", block %d: calculated "
+								"%X but expected %X",
+								readfilename, changed[blkno],
+								pg_checksum_page(page, blkno_global),
+								((PageHeader) page)->pd_checksum)));
+			if (checksum_failures == 5)
+				ereport(WARNING,
+						(errmsg("further checksum verification "
+								"failures in file \"%s\" will not "
+								"be reported", readfilename)));
+		}
+
+		if (decrypt_file)
+		{
+			decrypt_page(page, page, blkno_global, RELPERSISTENCE_PERMANENT);
+			if (DataChecksumsEnabled())
+				PageSetChecksumInplace(page, blkno_global);
+		}
+
+		sendData(page, BLCKSZ);
+
+		len += BLCKSZ;
+		throttle(BLCKSZ);
+	}
+
+	Assert(len == incrstat.st_size);
+
+	/* Pad to 512 byte boundary, per tar format requirements. */
+	pad = ((len + 511) & ~511) - len;
+	if (pad > 0)
+	{
+		MemSet(buf.data, 0, pad);
+		sendData(buf.data, pad);
+	}
+
+	FreeFile(fp);
+	pfree(changed);
+
+	if (checksum_failures > 1)
+	{
+		ereport(WARNING,
+				(errmsg_plural("file \"%s\" has a total of %d checksum verification failure",
+							   "file \"%s\" has a total of %d checksum verification failures",
+							   checksum_failures,
+							   readfilename, checksum_failures)));
+
+		pgstat_report_checksum_failures_in_db(dboid, checksum_failures);
+	}
+
+	total_checksum_failures += checksum_failures;
+
+	return true;
+}
+
 static int64
 _tarWriteHeader(const char *filename, const char *linktarget,
 				struct stat *statbuf, bool sizeonly)
@@ -1822,7 +2301,7 @@ _tarWriteHeader(const char *filename, const char *linktarget,
 				elog(ERROR, "unrecognized tar error: %d", rc);
 		}
 
-		pq_putmessage('d', h, sizeof(h));
+		sendData(h, sizeof(h));
 	}
 
 	return sizeof(h);
@@ -80,6 +80,8 @@ static SQLCmd *make_sqlcmd(void);
 %token K_TABLESPACE_MAP
 %token K_NOVERIFY_CHECKSUMS
 %token K_DECRYPT
+%token K_INCREMENTAL
+%token K_COMPRESSION
 %token K_TIMELINE
 %token K_PHYSICAL
 %token K_LOGICAL
@@ -159,6 +161,7 @@ var_name:	IDENT	{ $$ = $1; }
 /*
  * BASE_BACKUP [LABEL '<label>'] [PROGRESS] [FAST] [WAL] [NOWAIT]
  * [MAX_RATE %d] [TABLESPACE_MAP] [NOVERIFY_CHECKSUMS] [DECRYPT]
+ * [INCREMENTAL 'lsn'] [COMPRESSION %d]
  */
 base_backup:
 			K_BASE_BACKUP base_backup_opt_list
@@ -222,6 +225,16 @@ base_backup_opt:
 				  $$ = makeDefElem("decrypt",
 								   (Node *)makeInteger(true), -1);
 				}
+			| K_INCREMENTAL SCONST
+				{
+				  $$ = makeDefElem("incremental",
+								   (Node *)makeString($2), -1);
+				}
+			| K_COMPRESSION UCONST
+				{
+				  $$ = makeDefElem("compression",
+								   (Node *)makeInteger($2), -1);
+				}
 			;
 
 create_replication_slot:
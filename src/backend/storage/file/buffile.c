@@ -1150,6 +1150,41 @@ BufFileSeekBlock(BufFile *file, long blknum)
 					   SEEK_SET);
 }
 
+/*
+ * BufFilePrefetchBlock --- initiate asynchronous read of a range of blocks
+ *
+ * Asks the kernel to start reading 'nblocks' BLCKSZ-sized blocks starting at
+ * block 'blknum', so that a later BufFileRead() of them doesn't have to wait
+ * for I/O.  This is only a hint: the logical position is not moved, and
+ * blocks beyond the end of the file are ignored.
+ */
+void
+BufFilePrefetchBlock(BufFile *file, long blknum, int nblocks)
+{
+#ifdef USE_PREFETCH
+	while (nblocks > 0)
+	{
+		int			fileno = (int) (blknum / buffile_seg_blocks);
+		long		segblkno = blknum % buffile_seg_blocks;
+		int			nthistime;
+
+		if (fileno >= file->numFiles)
+			break;
+
+		/* don't cross a segment boundary in one request */
+		nthistime = (int) Min((long) nblocks, buffile_seg_blocks - segblkno);
+
+		(void) FilePrefetch(file->files[fileno],
+							(off_t) segblkno * BLCKSZ,
+							nthistime * BLCKSZ,
+							WAIT_EVENT_BUFFILE_READ);
+
+		blknum += nthistime;
+		nblocks -= nthistime;
+	}
+#endif							/* USE_PREFETCH */
+}
+
 static void
 BufFileTweak(char *tweak, BufFileCommon *file, bool is_transient)
 {
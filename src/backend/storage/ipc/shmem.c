@@ -144,6 +144,8 @@ InitShmemAllocation(void)
 	ShmemVariableCache = (VariableCache)
 		ShmemAlloc(sizeof(*ShmemVariableCache));
 	memset(ShmemVariableCache, 0, sizeof(*ShmemVariableCache));
+	/* zero is reserved for snapshots that can't be reused */
+	ShmemVariableCache->xactCompletionCount = 1;
 }
 
 /*
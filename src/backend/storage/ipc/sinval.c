@@ -21,6 +21,7 @@
 #include "storage/proc.h"
 #include "storage/sinvaladt.h"
 #include "utils/inval.h"
+#include "utils/sharedcatcache.h"
 
 
 uint64		SharedInvalidMessageCounter;
@@ -44,10 +45,14 @@ volatile sig_atomic_t catchupInterruptPending = false;
 /*
  * SendSharedInvalidMessages
  *	Add shared-cache-invalidation message(s) to the global SI message queue.
+ *
+ * Entries of the shared catalog cache are removed here as well, since every
+ * backend would otherwise have to do that for itself on receipt.
  */
 void
 SendSharedInvalidMessages(const SharedInvalidationMessage *msgs, int n)
 {
+	SharedCatCacheInvalidate(msgs, n);
 	SIInsertDataEntries(msgs, n);
 }
 
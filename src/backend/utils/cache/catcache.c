@@ -24,6 +24,7 @@
 #include "catalog/pg_collation.h"
 #include "catalog/pg_operator.h"
 #include "catalog/pg_type.h"
+#include "funcapi.h"
 #include "miscadmin.h"
 #ifdef CATCACHE_STATS
 #include "storage/ipc.h"		/* for on_proc_exit */
@@ -37,6 +38,8 @@
 #include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/resowner_private.h"
+#include "utils/sharedcatcache.h"
+#include "utils/snapmgr.h"
 #include "utils/syscache.h"
 
 
@@ -63,6 +66,9 @@
 /* Cache management header --- pointer is NULL until created */
 static CatCacheHeader *CacheHdr = NULL;
 
+/* GUC variable: memory limit for all catalog caches, in kB (0 = no limit) */
+int			catalog_cache_memory_limit = 0;
+
 static inline HeapTuple SearchCatCacheInternal(CatCache *cache,
 											   int nkeys,
 											   Datum v1, Datum v2,
@@ -88,6 +94,8 @@ static void CatCachePrintStats(int code, Datum arg);
 #endif
 static void CatCacheRemoveCTup(CatCache *cache, CatCTup *ct);
 static void CatCacheRemoveCList(CatCache *cache, CatCList *cl);
+static Size CatCTupSize(CatCache *cache, CatCTup *ct);
+static void CatCacheEvictEntries(Size limit);
 static void CatalogCacheInitializeCache(CatCache *cache);
 static CatCTup *CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp,
 										Datum *arguments,
@@ -456,6 +464,8 @@ CatCachePrintStats(int code, Datum arg)
 static void
 CatCacheRemoveCTup(CatCache *cache, CatCTup *ct)
 {
+	Size		size;
+
 	Assert(ct->refcount == 0);
 	Assert(ct->my_cache == cache);
 
@@ -471,8 +481,13 @@ CatCacheRemoveCTup(CatCache *cache, CatCTup *ct)
 		return;					/* nothing left to do */
 	}
 
-	/* delink from linked list */
+	/* delink from linked lists */
 	dlist_delete(&ct->cache_elem);
+	dlist_delete(&ct->lru_elem);
+
+	size = CatCTupSize(cache, ct);
+	cache->cc_nbytes -= size;
+	CacheHdr->ch_nbytes -= size;
 
 	/*
 	 * Free keys when we're dealing with a negative entry, normal entries just
@@ -529,6 +544,77 @@ CatCacheRemoveCList(CatCache *cache, CatCList *cl)
 	pfree(cl);
 }
 
+/*
+ *		CatCTupSize
+ *
+ * Memory used by the given cache entry, including separately allocated keys
+ */
+static Size
+CatCTupSize(CatCache *cache, CatCTup *ct)
+{
+	Size		size = GetMemoryChunkSpace(ct);
+
+	if (ct->negative)
+	{
+		int			i;
+
+		for (i = 0; i < cache->cc_nkeys; i++)
+		{
+			Form_pg_attribute att = TupleDescAttr(cache->cc_tupdesc,
+												  cache->cc_keyno[i] - 1);
+
+			if (!att->attbyval)
+				size += GetMemoryChunkSpace(DatumGetPointer(ct->keys[i]));
+		}
+	}
+
+	return size;
+}
+
+/*
+ *		CatCacheEvictEntries
+ *
+ * Remove unused entries from the catalog caches until their memory usage is
+ * no more than limit bytes, or there is nothing more to remove.
+ *
+ * This is a clock sweep over ch_lru: an entry found by a search since the
+ * last pass gets a second chance and moves to the end of the list, while
+ * other unreferenced entries are removed.  Entries that belong to a CatCList
+ * are left alone, since the list would have to go too; they are freed
+ * normally once the list is invalidated.
+ */
+static void
+CatCacheEvictEntries(Size limit)
+{
+	dlist_mutable_iter iter;
+	int			nscan;
+
+	/* visit each entry at most twice, so that we stop if all are in use */
+	nscan = CacheHdr->ch_ntup * 2;
+
+	dlist_foreach_modify(iter, &CacheHdr->ch_lru)
+	{
+		CatCTup    *ct = dlist_container(CatCTup, lru_elem, iter.cur);
+
+		if (CacheHdr->ch_nbytes <= limit || --nscan < 0)
+			break;
+
+		if (ct->recently_used || ct->refcount > 0 || ct->c_list != NULL)
+		{
+			ct->recently_used = false;
+			dlist_delete(&ct->lru_elem);
+			dlist_push_tail(&CacheHdr->ch_lru, &ct->lru_elem);
+			continue;
+		}
+
+		CACHE_elog(DEBUG2, "CatCacheEvictEntries(%s): evicting entry",
+				   ct->my_cache->cc_relname);
+
+		ct->my_cache->cc_nevictions++;
+		CatCacheRemoveCTup(ct->my_cache, ct);
+	}
+}
+
 
 /*
  *	CatCacheInvalidate
@@ -802,6 +888,8 @@ InitCatCache(int id,
 		CacheHdr = (CatCacheHeader *) palloc(sizeof(CatCacheHeader));
 		slist_init(&CacheHdr->ch_caches);
 		CacheHdr->ch_ntup = 0;
+		CacheHdr->ch_nbytes = 0;
+		dlist_init(&CacheHdr->ch_lru);
 #ifdef CATCACHE_STATS
 		/* set up to dump stats at backend exit */
 		on_proc_exit(CatCachePrintStats, 0);
@@ -1263,6 +1351,8 @@ SearchCatCacheInternal(CatCache *cache,
 		 * near the front of the hashbucket's list.)
 		 */
 		dlist_move_head(bucket, &ct->cache_elem);
+		ct->recently_used = true;
+		cache->cc_nhits++;
 
 		/*
 		 * If it's a positive entry, bump its refcount and return it. If it's
@@ -1322,6 +1412,10 @@ SearchCatCacheMiss(CatCache *cache,
 	HeapTuple	ntp;
 	CatCTup    *ct;
 	Datum		arguments[CATCACHE_MAXKEYS];
+	bool		use_shared;
+	uint64		shared_generation = 0;
+
+	cache->cc_nmisses++;
 
 	/* Initialize local parameter array */
 	arguments[0] = v1;
@@ -1329,6 +1423,39 @@ SearchCatCacheMiss(CatCache *cache,
 	arguments[2] = v3;
 	arguments[3] = v4;
 
+	/*
+	 * Before going to the catalog, see if another backend has already loaded
+	 * the tuple into the shared catalog cache.
+	 */
+	use_shared = SharedCatCacheEnabled();
+	if (use_shared)
+	{
+		ntp = SharedCatCacheLookup(cache, hashValue, arguments,
+								   &shared_generation);
+		if (ntp != NULL)
+		{
+			ct = CatalogCacheCreateEntry(cache, ntp, arguments,
+										 hashValue, hashIndex,
+										 false);
+			heap_freetuple(ntp);
+			/* immediately set the refcount to 1 */
+			ResourceOwnerEnlargeCatCacheRefs(CurrentResourceOwner);
+			ct->refcount++;
+			ResourceOwnerRememberCatCacheRef(CurrentResourceOwner, &ct->tuple);
+
+			CACHE_elog(DEBUG2, "SearchCatCache(%s): found in shared cache",
+					   cache->cc_relname);
+
+			return &ct->tuple;
+		}
+
+		/*
+		 * What we read below may be published only if it was read after the
+		 * generation was fetched, so make sure we get a new snapshot.
+		 */
+		InvalidateCatalogSnapshot();
+	}
+
 	/*
 	 * Ok, need to make a lookup in the relation, copy the scankey and fill
 	 * out any per-call fields.
@@ -1374,6 +1501,10 @@ SearchCatCacheMiss(CatCache *cache,
 		ResourceOwnerEnlargeCatCacheRefs(CurrentResourceOwner);
 		ct->refcount++;
 		ResourceOwnerRememberCatCacheRef(CurrentResourceOwner, &ct->tuple);
+
+		if (use_shared)
+			SharedCatCacheInsert(cache, hashValue, &ct->tuple,
+								 shared_generation);
 		break;					/* assume only one match */
 	}
 
@@ -1809,6 +1940,15 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	CatCTup    *ct;
 	HeapTuple	dtp;
 	MemoryContext oldcxt;
+	Size		size;
+
+	/*
+	 * Make room for the new entry first, so that it can't be evicted before
+	 * the caller has had a chance to pin it.
+	 */
+	if (catalog_cache_memory_limit > 0 &&
+		CacheHdr->ch_nbytes >= (Size) catalog_cache_memory_limit * 1024)
+		CatCacheEvictEntries((Size) catalog_cache_memory_limit * 1024);
 
 	/* negative entries have no tuple associated */
 	if (ntp)
@@ -1888,8 +2028,14 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	ct->dead = false;
 	ct->negative = negative;
 	ct->hash_value = hashValue;
+	ct->recently_used = true;
 
 	dlist_push_head(&cache->cc_bucket[hashIndex], &ct->cache_elem);
+	dlist_push_tail(&CacheHdr->ch_lru, &ct->lru_elem);
+
+	size = CatCTupSize(cache, ct);
+	cache->cc_nbytes += size;
+	CacheHdr->ch_nbytes += size;
 
 	cache->cc_ntup++;
 	CacheHdr->ch_ntup++;
@@ -2090,3 +2236,67 @@ PrintCatCacheListLeakWarning(CatCList *list)
 		 list->my_cache->cc_relname, list->my_cache->id,
 		 list, list->refcount);
 }
+
+/*
+ * pg_get_backend_catcache_stats
+ *		SQL SRF showing the catalog caches of the local backend.
+ */
+Datum
+pg_get_backend_catcache_stats(PG_FUNCTION_ARGS)
+{
+#define PG_GET_BACKEND_CATCACHE_STATS_COLS	8
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	slist_iter	iter;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	slist_foreach(iter, &CacheHdr->ch_caches)
+	{
+		CatCache   *cache = slist_container(CatCache, cc_next, iter.cur);
+		Datum		values[PG_GET_BACKEND_CATCACHE_STATS_COLS];
+		bool		nulls[PG_GET_BACKEND_CATCACHE_STATS_COLS];
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[0] = Int32GetDatum(cache->id);
+		values[1] = ObjectIdGetDatum(cache->cc_reloid);
+		values[2] = ObjectIdGetDatum(cache->cc_indexoid);
+		values[3] = Int32GetDatum(cache->cc_ntup);
+		values[4] = Int64GetDatum((int64) cache->cc_nbytes);
+		values[5] = Int64GetDatum(cache->cc_nhits);
+		values[6] = Int64GetDatum(cache->cc_nmisses);
+		values[7] = Int64GetDatum(cache->cc_nevictions);
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
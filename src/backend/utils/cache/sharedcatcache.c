@@ -0,0 +1,756 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedcatcache.c
+ *	  Catalog cache tuples shared by all backends.
+ *
+ * Every backend normally fills its own catcache by reading the system
+ * catalogs, so a freshly started backend repeats the same index scans that
+ * every other backend already did.  When shared_catcache_size is set, a
+ * backend that misses its local catcache first looks for the tuple here,
+ * and publishes what it read from the catalogs for the benefit of others.
+ * The local catcache stays the primary cache; this is only a second level
+ * that makes filling it cheaper.
+ *
+ * Only positive single-tuple lookups are shared.  Negative entries and
+ * catcache lists are not, because proving them still valid would need
+ * knowledge of every tuple that could match, which the invalidation
+ * messages don't provide.
+ *
+ * The entries are kept in a fixed-size shared hash table keyed by database,
+ * cache ID and hash value --- exactly what a catcache invalidation message
+ * carries --- and the tuple bodies live in a DSA area created in place in
+ * the main shared memory segment, with its size limited so that it never
+ * needs to add DSM segments.
+ *
+ * When either is full, entries are evicted with a clock sweep.  Each hash
+ * partition keeps its entries in a ring, in insertion order, and a lookup
+ * that finds an entry marks it as referenced.  To make room, we visit the
+ * partitions round-robin and, in each, evict entries from the head of the
+ * ring that haven't been referenced since the sweep last passed them.  So
+ * entries of databases nobody connects to anymore are eventually evicted,
+ * rather than keeping the cache full for good.
+ *
+ * Entries are removed by the backend that sends the invalidation messages,
+ * from SendSharedInvalidMessages(), which runs after the changes have been
+ * committed.  An error there would be promoted to PANIC, so that path must
+ * not allocate memory or throw: every process attaches to the DSA area
+ * at startup, in BaseInit(), and if a process nevertheless finds itself
+ * without an attachment when it has entries to remove, it disables the
+ * shared cache for everyone rather than failing.  To close the race against a backend that read the old
+ * version of a tuple but publishes it only after the invalidation has gone
+ * by, each hash partition carries a generation counter that every
+ * invalidation bumps.  The reader notes the generation before scanning the
+ * catalog with a fresh snapshot, and the insertion is abandoned if it has
+ * changed since.
+ *
+ * A transaction that has modified anything must see its own uncommitted
+ * catalog changes, which the shared entries don't reflect and mustn't
+ * contain, so such transactions neither use nor fill the shared cache.
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/cache/sharedcatcache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/xact.h"
+#include "lib/ilist.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/dsa.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/sharedcatcache.h"
+#include "utils/snapmgr.h"
+
+
+/* Number of partitions of the shared hash table; must be a power of 2 */
+#define SHARED_CATCACHE_PARTITIONS	64
+
+/* Expected average space used by a tuple, for sizing the hash table */
+#define SHARED_CATCACHE_AVG_TUPLE_SIZE	256
+
+/* Number of entries evicted from a partition at a time to make space */
+#define SHARED_CATCACHE_EVICT_BATCH	8
+
+/* Hash key of the shared cache, matching catcache inval messages */
+typedef struct SharedCatCacheKey
+{
+	Oid			dbId;			/* database ID, or 0 for shared catalogs */
+	int			cacheId;		/* syscache ID */
+	uint32		hashValue;		/* catcache hash value of the keys */
+} SharedCatCacheKey;
+
+typedef struct SharedCatCacheEntry
+{
+	SharedCatCacheKey key;		/* hash key; must be first */
+	dsa_pointer tuples;			/* list of SharedCatCacheTuples */
+	dlist_node clock_node;		/* link in the partition's clock ring */
+
+	/*
+	 * Set by lookups, which hold only a shared lock on the partition, and
+	 * cleared by the clock sweep.  A lost update can only make the entry be
+	 * evicted a little early.
+	 */
+	bool		referenced;
+} SharedCatCacheEntry;
+
+/*
+ * A tuple stored in the DSA area.  Several tuples can have the same key,
+ * when their lookup keys have colliding hash values.
+ */
+typedef struct SharedCatCacheTuple
+{
+	dsa_pointer next;			/* next tuple with the same key */
+	ItemPointerData t_self;
+	Oid			t_tableOid;
+	uint32		t_len;
+	/* tuple data follows, at a MAXALIGN'd offset */
+} SharedCatCacheTuple;
+
+#define SHARED_CATCACHE_TUPLE_HDRSZ	MAXALIGN(sizeof(SharedCatCacheTuple))
+
+#define SharedCatCacheTupleData(sct) \
+	((HeapTupleHeader) ((char *) (sct) + SHARED_CATCACHE_TUPLE_HDRSZ))
+
+typedef struct SharedCatCacheControl
+{
+	LWLockPadded locks[SHARED_CATCACHE_PARTITIONS];
+	/* bumped by each invalidation, protected by the partition's lock */
+	uint64		generations[SHARED_CATCACHE_PARTITIONS];
+	/* entries of each partition, oldest first; protected likewise */
+	dlist_head	clocks[SHARED_CATCACHE_PARTITIONS];
+	/* next partition the clock sweep evicts from */
+	pg_atomic_uint32 nextVictimPartition;
+	/* set once an invalidation could not be applied; never cleared */
+	pg_atomic_uint32 disabled;
+	/* space for the DSA area holding the tuples */
+	char		area[FLEXIBLE_ARRAY_MEMBER];
+} SharedCatCacheControl;
+
+/* GUC variable */
+int			shared_catcache_size = 0;
+
+static SharedCatCacheControl *SharedCatCache = NULL;
+static HTAB *SharedCatCacheHash = NULL;
+
+/* this process's attachment to the DSA area, set up by SharedCatCacheAttach */
+static dsa_area *SharedCatCacheArea = NULL;
+
+static Size SharedCatCacheAreaSize(void);
+static long SharedCatCacheMaxEntries(void);
+static void SharedCatCacheDisable(void);
+static uint32 SharedCatCacheHashKey(SharedCatCacheKey *key, Oid dbId,
+									int cacheId, uint32 hashValue);
+static bool SharedCatCacheTupleMatches(CatCache *cache, HeapTuple tuple,
+									   Datum *arguments);
+static void SharedCatCacheFreeTuples(dsa_pointer tuples);
+static void SharedCatCacheRemoveEntry(SharedCatCacheEntry *entry,
+									  uint32 hashcode);
+static bool SharedCatCacheEvictFromPartition(int partition, int nentries);
+static bool SharedCatCacheEvict(void);
+
+
+/*
+ * Size of the DSA area holding the tuples.
+ */
+static Size
+SharedCatCacheAreaSize(void)
+{
+	return Max(mul_size((Size) shared_catcache_size, 1024),
+			   dsa_minimum_size());
+}
+
+/*
+ * Number of entries of the shared hash table.
+ */
+static long
+SharedCatCacheMaxEntries(void)
+{
+	return (long) (SharedCatCacheAreaSize() / SHARED_CATCACHE_AVG_TUPLE_SIZE);
+}
+
+/*
+ * Estimate space needed for the shared catalog cache.
+ */
+Size
+SharedCatCacheShmemSize(void)
+{
+	Size		size;
+
+	if (shared_catcache_size == 0)
+		return 0;
+
+	size = add_size(offsetof(SharedCatCacheControl, area),
+					SharedCatCacheAreaSize());
+	size = add_size(size, hash_estimate_size(SharedCatCacheMaxEntries(),
+											 sizeof(SharedCatCacheEntry)));
+
+	return size;
+}
+
+/*
+ * Initialize the shared catalog cache during postmaster startup.
+ */
+void
+SharedCatCacheShmemInit(void)
+{
+	HASHCTL		info;
+	long		max_entries;
+	bool		found;
+
+	if (shared_catcache_size == 0)
+		return;
+
+	SharedCatCache = (SharedCatCacheControl *)
+		ShmemInitStruct("Shared Catcache",
+						add_size(offsetof(SharedCatCacheControl, area),
+								 SharedCatCacheAreaSize()),
+						&found);
+
+	if (!found)
+	{
+		dsa_area   *area;
+		int			i;
+
+		for (i = 0; i < SHARED_CATCACHE_PARTITIONS; i++)
+		{
+			LWLockInitialize(&SharedCatCache->locks[i].lock,
+							 LWTRANCHE_SHARED_CATCACHE);
+			SharedCatCache->generations[i] = 0;
+			dlist_init(&SharedCatCache->clocks[i]);
+		}
+		pg_atomic_init_u32(&SharedCatCache->nextVictimPartition, 0);
+		pg_atomic_init_u32(&SharedCatCache->disabled, 0);
+
+		/*
+		 * The area lives entirely in the space reserved for it above; cap it
+		 * there so that it never tries to create DSM segments.
+		 */
+		area = dsa_create_in_place(SharedCatCache->area,
+								   SharedCatCacheAreaSize(),
+								   LWTRANCHE_SHARED_CATCACHE_DSA, NULL);
+		dsa_set_size_limit(area, SharedCatCacheAreaSize());
+		dsa_pin(area);
+		dsa_detach(area);
+	}
+
+	max_entries = SharedCatCacheMaxEntries();
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(SharedCatCacheKey);
+	info.entrysize = sizeof(SharedCatCacheEntry);
+	info.num_partitions = SHARED_CATCACHE_PARTITIONS;
+
+	SharedCatCacheHash = ShmemInitHash("Shared Catcache Hash",
+									   max_entries, max_entries,
+									   &info,
+									   HASH_ELEM | HASH_BLOBS |
+									   HASH_PARTITION | HASH_FIXED_SIZE);
+}
+
+/*
+ * SharedCatCacheAttach
+ *
+ * Attach to the DSA area holding the tuples.  Called from BaseInit() by
+ * every process that can look up or invalidate catcache entries, so that
+ * the invalidation path never has to do it.
+ */
+void
+SharedCatCacheAttach(void)
+{
+	MemoryContext oldcxt;
+
+	if (SharedCatCache == NULL || SharedCatCacheArea != NULL)
+		return;
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	SharedCatCacheArea = dsa_attach_in_place(SharedCatCache->area, NULL);
+	dsa_pin_mapping(SharedCatCacheArea);
+	MemoryContextSwitchTo(oldcxt);
+
+	before_shmem_exit(dsa_on_shmem_exit_release_in_place,
+					  PointerGetDatum(SharedCatCache->area));
+}
+
+/*
+ * Stop all processes from using the shared catalog cache, when entries
+ * that should have been invalidated may remain in it.  This can't fail.
+ */
+static void
+SharedCatCacheDisable(void)
+{
+	if (pg_atomic_exchange_u32(&SharedCatCache->disabled, 1) == 0)
+		elog(LOG, "shared catalog cache disabled because an invalidation could not be applied");
+}
+
+/*
+ * Can the current transaction use the shared catalog cache?
+ */
+bool
+SharedCatCacheEnabled(void)
+{
+	if (SharedCatCache == NULL || SharedCatCacheArea == NULL ||
+		!IsNormalProcessingMode())
+		return false;
+
+	if (pg_atomic_read_u32(&SharedCatCache->disabled) != 0)
+		return false;
+
+	/*
+	 * Our own uncommitted catalog changes must neither be hidden from us by
+	 * older shared entries nor be published to others.
+	 */
+	if (TransactionIdIsValid(GetTopTransactionIdIfAny()))
+		return false;
+
+	/* Logical decoding looks at the catalogs as of some point in the past */
+	if (HistoricSnapshotActive())
+		return false;
+
+	return true;
+}
+
+/*
+ * Fill in a hash key, and return its hash code.
+ */
+static uint32
+SharedCatCacheHashKey(SharedCatCacheKey *key, Oid dbId, int cacheId,
+					  uint32 hashValue)
+{
+	/* make sure any padding bytes are zero */
+	memset(key, 0, sizeof(SharedCatCacheKey));
+	key->dbId = dbId;
+	key->cacheId = cacheId;
+	key->hashValue = hashValue;
+
+	return get_hash_value(SharedCatCacheHash, key);
+}
+
+#define SharedCatCachePartition(hashcode) \
+	((hashcode) % SHARED_CATCACHE_PARTITIONS)
+
+#define SharedCatCacheCatalogDbId(cache) \
+	((cache)->cc_relisshared ? InvalidOid : MyDatabaseId)
+
+/*
+ * Does the tuple have the given lookup keys?
+ */
+static bool
+SharedCatCacheTupleMatches(CatCache *cache, HeapTuple tuple, Datum *arguments)
+{
+	int			i;
+
+	for (i = 0; i < cache->cc_nkeys; i++)
+	{
+		Datum		datum;
+		bool		isnull;
+
+		datum = heap_getattr(tuple, cache->cc_keyno[i], cache->cc_tupdesc,
+							 &isnull);
+		Assert(!isnull);
+
+		if (!(cache->cc_fastequal[i]) (datum, arguments[i]))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * SharedCatCacheLookup
+ *
+ * Look for the tuple with the given lookup keys.  If found, a palloc'd copy
+ * is returned.  If not, NULL is returned and *generation is set to the value
+ * to pass to SharedCatCacheInsert() once the tuple has been read from the
+ * catalog.  The catalog snapshot used for that must be taken after this
+ * call.
+ */
+HeapTuple
+SharedCatCacheLookup(CatCache *cache, uint32 hashValue, Datum *arguments,
+					 uint64 *generation)
+{
+	SharedCatCacheKey key;
+	SharedCatCacheEntry *entry;
+	uint32		hashcode;
+	int			partition;
+	LWLock	   *lock;
+	HeapTuple	result = NULL;
+
+	hashcode = SharedCatCacheHashKey(&key, SharedCatCacheCatalogDbId(cache),
+									 cache->id, hashValue);
+	partition = SharedCatCachePartition(hashcode);
+	lock = &SharedCatCache->locks[partition].lock;
+
+	LWLockAcquire(lock, LW_SHARED);
+
+	*generation = SharedCatCache->generations[partition];
+
+	/* recheck, in case the cache was disabled since SharedCatCacheEnabled */
+	if (pg_atomic_read_u32(&SharedCatCache->disabled) != 0)
+		entry = NULL;
+	else
+		entry = (SharedCatCacheEntry *)
+			hash_search_with_hash_value(SharedCatCacheHash, &key, hashcode,
+										HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		dsa_pointer dp;
+
+		for (dp = entry->tuples; DsaPointerIsValid(dp);)
+		{
+			SharedCatCacheTuple *sct = dsa_get_address(SharedCatCacheArea,
+														dp);
+			HeapTupleData tuple;
+
+			tuple.t_len = sct->t_len;
+			tuple.t_self = sct->t_self;
+			tuple.t_tableOid = sct->t_tableOid;
+			tuple.t_data = SharedCatCacheTupleData(sct);
+
+			if (SharedCatCacheTupleMatches(cache, &tuple, arguments))
+			{
+				result = heap_copytuple(&tuple);
+				entry->referenced = true;
+				break;
+			}
+
+			dp = sct->next;
+		}
+	}
+
+	LWLockRelease(lock);
+
+	return result;
+}
+
+/*
+ * SharedCatCacheInsert
+ *
+ * Publish a tuple read from the catalog after a failed SharedCatCacheLookup.
+ * Nothing is done if an invalidation has hit the partition in between.  If
+ * the cache is full, we evict some entries; if that doesn't make enough
+ * room right away, the tuple isn't published, but later insertions will
+ * find the space.
+ */
+void
+SharedCatCacheInsert(CatCache *cache, uint32 hashValue, HeapTuple tuple,
+					 uint64 generation)
+{
+	SharedCatCacheKey key;
+	SharedCatCacheEntry *entry = NULL;
+	SharedCatCacheTuple *sct;
+	dsa_area   *area = SharedCatCacheArea;
+	dsa_pointer dp;
+	uint32		hashcode;
+	int			partition;
+	LWLock	   *lock;
+	bool		found;
+	bool		hash_full = false;
+
+	Assert(!HeapTupleHasExternal(tuple));
+	Assert(area != NULL);
+
+	/* copy the tuple before taking the lock */
+	dp = dsa_allocate_extended(area,
+							   SHARED_CATCACHE_TUPLE_HDRSZ + tuple->t_len,
+							   DSA_ALLOC_NO_OOM);
+	if (!DsaPointerIsValid(dp) && SharedCatCacheEvict())
+		dp = dsa_allocate_extended(area,
+								   SHARED_CATCACHE_TUPLE_HDRSZ + tuple->t_len,
+								   DSA_ALLOC_NO_OOM);
+	if (!DsaPointerIsValid(dp))
+		return;
+
+	sct = dsa_get_address(area, dp);
+	sct->next = InvalidDsaPointer;
+	sct->t_self = tuple->t_self;
+	sct->t_tableOid = tuple->t_tableOid;
+	sct->t_len = tuple->t_len;
+	memcpy(SharedCatCacheTupleData(sct), tuple->t_data, tuple->t_len);
+
+	hashcode = SharedCatCacheHashKey(&key, SharedCatCacheCatalogDbId(cache),
+									 cache->id, hashValue);
+	partition = SharedCatCachePartition(hashcode);
+	lock = &SharedCatCache->locks[partition].lock;
+
+	LWLockAcquire(lock, LW_EXCLUSIVE);
+
+	if (SharedCatCache->generations[partition] == generation &&
+		pg_atomic_read_u32(&SharedCatCache->disabled) == 0)
+	{
+		entry = (SharedCatCacheEntry *)
+			hash_search_with_hash_value(SharedCatCacheHash, &key, hashcode,
+										HASH_ENTER_NULL, &found);
+
+		/* if the hash table is full, try to evict from this partition */
+		if (entry == NULL &&
+			SharedCatCacheEvictFromPartition(partition,
+											 SHARED_CATCACHE_EVICT_BATCH))
+			entry = (SharedCatCacheEntry *)
+				hash_search_with_hash_value(SharedCatCacheHash, &key, hashcode,
+											HASH_ENTER_NULL, &found);
+		else if (entry == NULL)
+			hash_full = true;
+	}
+
+	if (entry != NULL)
+	{
+		dsa_pointer cur;
+
+		if (!found)
+		{
+			entry->tuples = InvalidDsaPointer;
+			entry->referenced = false;
+			dlist_push_tail(&SharedCatCache->clocks[partition],
+							&entry->clock_node);
+		}
+
+		/* someone else may have published the same tuple meanwhile */
+		for (cur = entry->tuples; DsaPointerIsValid(cur);)
+		{
+			SharedCatCacheTuple *other = dsa_get_address(area, cur);
+
+			if (ItemPointerEquals(&other->t_self, &sct->t_self))
+				break;
+			cur = other->next;
+		}
+
+		if (!DsaPointerIsValid(cur))
+		{
+			sct->next = entry->tuples;
+			entry->tuples = dp;
+			dp = InvalidDsaPointer;
+		}
+	}
+
+	LWLockRelease(lock);
+
+	/* free our copy if it wasn't linked in */
+	if (DsaPointerIsValid(dp))
+		dsa_free(area, dp);
+
+	/*
+	 * If this partition had nothing to evict, make room elsewhere, so that
+	 * the next insertion succeeds.
+	 */
+	if (hash_full)
+		(void) SharedCatCacheEvict();
+}
+
+/*
+ * Free a list of tuples.  The caller must have checked that we are attached
+ * to the area.
+ */
+static void
+SharedCatCacheFreeTuples(dsa_pointer tuples)
+{
+	dsa_area   *area = SharedCatCacheArea;
+
+	Assert(area != NULL);
+
+	while (DsaPointerIsValid(tuples))
+	{
+		SharedCatCacheTuple *sct = dsa_get_address(area, tuples);
+		dsa_pointer next = sct->next;
+
+		dsa_free(area, tuples);
+		tuples = next;
+	}
+}
+
+/*
+ * Remove an entry and free its tuples.  The caller must hold the exclusive
+ * lock on the entry's partition.
+ */
+static void
+SharedCatCacheRemoveEntry(SharedCatCacheEntry *entry, uint32 hashcode)
+{
+	SharedCatCacheFreeTuples(entry->tuples);
+	dlist_delete(&entry->clock_node);
+	hash_search_with_hash_value(SharedCatCacheHash, &entry->key, hashcode,
+								HASH_REMOVE, NULL);
+}
+
+/*
+ * Evict up to 'nentries' entries from a partition, giving referenced ones a
+ * second chance.  The caller must hold the exclusive lock on the partition.
+ * Returns true if anything was evicted.
+ */
+static bool
+SharedCatCacheEvictFromPartition(int partition, int nentries)
+{
+	dlist_head *clock = &SharedCatCache->clocks[partition];
+	int			nevicted = 0;
+
+	/*
+	 * No lookup can mark entries as referenced while we hold the exclusive
+	 * lock, so this stops after at most one full turn of the ring.
+	 */
+	while (nevicted < nentries && !dlist_is_empty(clock))
+	{
+		SharedCatCacheEntry *entry =
+		dlist_head_element(SharedCatCacheEntry, clock_node, clock);
+
+		if (entry->referenced)
+		{
+			entry->referenced = false;
+			dlist_delete(&entry->clock_node);
+			dlist_push_tail(clock, &entry->clock_node);
+			continue;
+		}
+
+		SharedCatCacheRemoveEntry(entry,
+								  get_hash_value(SharedCatCacheHash,
+												 &entry->key));
+		nevicted++;
+	}
+
+	return nevicted > 0;
+}
+
+/*
+ * Make room for new entries by evicting from the next partitions in
+ * round-robin order, until some entry has been evicted.  The caller must
+ * not hold any partition lock.  Returns true if anything was evicted.
+ */
+static bool
+SharedCatCacheEvict(void)
+{
+	int			i;
+
+	for (i = 0; i < SHARED_CATCACHE_PARTITIONS; i++)
+	{
+		int			partition;
+		bool		evicted;
+
+		partition = pg_atomic_fetch_add_u32(&SharedCatCache->nextVictimPartition, 1) %
+			SHARED_CATCACHE_PARTITIONS;
+
+		LWLockAcquire(&SharedCatCache->locks[partition].lock, LW_EXCLUSIVE);
+		evicted = SharedCatCacheEvictFromPartition(partition,
+												   SHARED_CATCACHE_EVICT_BATCH);
+		LWLockRelease(&SharedCatCache->locks[partition].lock);
+
+		if (evicted)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Remove the entry for a catcache inval message.
+ */
+static void
+SharedCatCacheInvalidateEntry(Oid dbId, int cacheId, uint32 hashValue)
+{
+	SharedCatCacheKey key;
+	SharedCatCacheEntry *entry;
+	uint32		hashcode;
+	int			partition;
+	LWLock	   *lock;
+
+	hashcode = SharedCatCacheHashKey(&key, dbId, cacheId, hashValue);
+	partition = SharedCatCachePartition(hashcode);
+	lock = &SharedCatCache->locks[partition].lock;
+
+	LWLockAcquire(lock, LW_EXCLUSIVE);
+
+	SharedCatCache->generations[partition]++;
+
+	entry = (SharedCatCacheEntry *)
+		hash_search_with_hash_value(SharedCatCacheHash, &key, hashcode,
+									HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		if (SharedCatCacheArea != NULL)
+			SharedCatCacheRemoveEntry(entry, hashcode);
+		else
+			SharedCatCacheDisable();
+	}
+
+	LWLockRelease(lock);
+}
+
+/*
+ * SharedCatCacheInvalidateDatabase
+ *
+ * Remove all entries of a database, or of the shared catalogs if dbId is
+ * InvalidOid.  This is used for whole-catalog invalidations, which carry
+ * no finer information, and when a database is dropped.
+ */
+void
+SharedCatCacheInvalidateDatabase(Oid dbId)
+{
+	HASH_SEQ_STATUS status;
+	SharedCatCacheEntry *entry;
+	int			i;
+
+	if (SharedCatCache == NULL)
+		return;
+
+	/* lock all partitions, in order to avoid deadlocks */
+	for (i = 0; i < SHARED_CATCACHE_PARTITIONS; i++)
+	{
+		LWLockAcquire(&SharedCatCache->locks[i].lock, LW_EXCLUSIVE);
+		SharedCatCache->generations[i]++;
+	}
+
+	hash_seq_init(&status, SharedCatCacheHash);
+	while ((entry = (SharedCatCacheEntry *) hash_seq_search(&status)) != NULL)
+	{
+		if (entry->key.dbId != dbId)
+			continue;
+
+		if (SharedCatCacheArea == NULL)
+		{
+			SharedCatCacheDisable();
+			hash_seq_term(&status);
+			break;
+		}
+
+		SharedCatCacheRemoveEntry(entry,
+								  get_hash_value(SharedCatCacheHash,
+												 &entry->key));
+	}
+
+	for (i = SHARED_CATCACHE_PARTITIONS; --i >= 0;)
+		LWLockRelease(&SharedCatCache->locks[i].lock);
+}
+
+/*
+ * SharedCatCacheInvalidate
+ *
+ * Apply a batch of shared invalidation messages to the shared catalog
+ * cache.  Called by the sender of the messages, once they are certain to be
+ * needed, i.e. after commit.
+ */
+void
+SharedCatCacheInvalidate(const SharedInvalidationMessage *msgs, int n)
+{
+	int			i;
+
+	if (SharedCatCache == NULL)
+		return;
+
+	for (i = 0; i < n; i++)
+	{
+		const SharedInvalidationMessage *msg = &msgs[i];
+
+		if (msg->id >= 0)
+			SharedCatCacheInvalidateEntry(msg->cc.dbId, msg->cc.id,
+										  msg->cc.hashValue);
+		else if (msg->id == SHAREDINVALCATALOG_ID)
+			SharedCatCacheInvalidateDatabase(msg->cat.dbId);
+	}
+}
@@ -60,6 +60,7 @@
 #include "utils/pg_locale.h"
 #include "utils/portal.h"
 #include "utils/ps_status.h"
+#include "utils/sharedcatcache.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 #include "utils/timeout.h"
@@ -550,6 +551,12 @@ BaseInit(void)
 	InitSync();
 	smgrinit();
 	InitBufferPoolAccess();
+
+	/*
+	 * Attach to the shared catalog cache now, since it can't be done safely
+	 * when we first need to invalidate its entries, after commit.
+	 */
+	SharedCatCacheAttach();
 }
 
 
@@ -458,6 +458,12 @@ AllocSetContextCreateInternal(MemoryContext parent,
 								parent,
 								name);
 
+			/*
+			 * The keeper block never stopped being counted in the backend's
+			 * total while the context sat in the freelist.
+			 */
+			set->header.mem_allocated = set->keeper->endptr - ((char *) set);
+
 			return (MemoryContext) set;
 		}
 	}
@@ -546,6 +552,8 @@ AllocSetContextCreateInternal(MemoryContext parent,
 						parent,
 						name);
 
+	MemoryContextAccountAlloc((MemoryContext) set, firstBlockSize);
+
 	return (MemoryContext) set;
 }
 
@@ -604,6 +612,7 @@ AllocSetReset(MemoryContext context)
 		else
 		{
 			/* Normal case, release the block */
+			MemoryContextAccountFree(context, block->endptr - ((char *) block));
 #ifdef CLOBBER_FREED_MEMORY
 			wipe_mem(block, block->freeptr - ((char *) block));
 #endif
@@ -665,6 +674,8 @@ AllocSetDelete(MemoryContext context)
 				freelist->num_free--;
 
 				/* All that remains is to free the header/initial block */
+				MemoryContextAccountFree((MemoryContext) oldset,
+										 oldset->header.mem_allocated);
 				free(oldset);
 			}
 			Assert(freelist->num_free == 0);
@@ -694,6 +705,7 @@ AllocSetDelete(MemoryContext context)
 	}
 
 	/* Finally, free the context header, including the keeper block */
+	MemoryContextAccountFree(context, context->mem_allocated);
 	free(set);
 }
 
@@ -733,6 +745,9 @@ AllocSetAlloc(MemoryContext context, Size size)
 		block = (AllocBlock) malloc(blksize);
 		if (block == NULL)
 			return NULL;
+
+		MemoryContextAccountAlloc(context, blksize);
+
 		block->aset = set;
 		block->freeptr = block->endptr = ((char *) block) + blksize;
 
@@ -928,6 +943,8 @@ AllocSetAlloc(MemoryContext context, Size size)
 		if (block == NULL)
 			return NULL;
 
+		MemoryContextAccountAlloc(context, blksize);
+
 		block->aset = set;
 		block->freeptr = ((char *) block) + ALLOC_BLOCKHDRSZ;
 		block->endptr = ((char *) block) + blksize;
@@ -1028,6 +1045,9 @@ AllocSetFree(MemoryContext context, void *pointer)
 			set->blocks = block->next;
 		if (block->next)
 			block->next->prev = block->prev;
+
+		MemoryContextAccountFree(context, block->endptr - ((char *) block));
+
 #ifdef CLOBBER_FREED_MEMORY
 		wipe_mem(block, block->freeptr - ((char *) block));
 #endif
@@ -1126,6 +1146,10 @@ AllocSetRealloc(MemoryContext context, void *pointer, Size size)
 		}
 		block->freeptr = block->endptr = ((char *) block) + blksize;
 
+		MemoryContextAccountFree(context,
+								 oldsize + ALLOC_BLOCKHDRSZ + ALLOC_CHUNKHDRSZ);
+		MemoryContextAccountAlloc(context, blksize);
+
 		/* Update pointers since block has likely been moved */
 		chunk = (AllocChunk) (((char *) block) + ALLOC_BLOCKHDRSZ);
 		pointer = AllocChunkGetPointer(chunk);
@@ -0,0 +1,670 @@
+/*-------------------------------------------------------------------------
+ *
+ * bump.c
+ *	  Bump allocator definitions.
+ *
+ * Bump is a custom MemoryContext implementation designed for cases where a
+ * large number of chunks are allocated and none of them is ever freed
+ * individually; the memory is only released by resetting or deleting the
+ * whole context.
+ *
+ * Portions Copyright (c) 2017-2019, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/mmgr/bump.c
+ *
+ *
+ *	Since chunks are never freed, there is no need to find a chunk's block
+ *	or size from its address, so chunks have no header at all: an allocation
+ *	just advances the current block's free pointer by the MAXALIGN'd request
+ *	size.  That saves the 16 or more bytes per chunk (plus the power-of-2
+ *	rounding) that aset.c spends, which matters a great deal when storing
+ *	many small objects.
+ *
+ *	The price is that pfree(), repalloc(), GetMemoryChunkSpace(),
+ *	GetMemoryChunkContext() and MemoryContextContains() must never be used
+ *	on a chunk allocated here, because they all look at the chunk header.
+ *	When MEMORY_CONTEXT_CHECKING is defined we do add a chunk header, so
+ *	that such calls are caught with an error rather than crashing, and so
+ *	that sentinels can detect writes past the end of a chunk.
+ *
+ *	Blocks start at initBlockSize and double in size up to maxBlockSize,
+ *	like aset.c.  Requests larger than allocChunkLimit get a dedicated
+ *	block.  The first block is allocated together with the context header
+ *	and is kept over resets, so a context that is reset repeatedly doesn't
+ *	thrash malloc().
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "lib/ilist.h"
+#include "utils/memdebug.h"
+#include "utils/memutils.h"
+
+
+#define Bump_BLOCKHDRSZ	MAXALIGN(sizeof(BumpBlock))
+
+#ifdef MEMORY_CONTEXT_CHECKING
+#define Bump_CHUNKHDRSZ	sizeof(BumpChunk)
+#else
+#define Bump_CHUNKHDRSZ	0
+#endif
+
+/*
+ * The chunk size limit is at most 1/BUMP_CHUNK_FRACTION of maxBlockSize, so
+ * that a stream of maximum-sized requests wastes at most that fraction of
+ * each block.
+ */
+#define BUMP_CHUNK_FRACTION	8
+
+typedef struct BumpBlock BumpBlock; /* forward reference */
+
+/*
+ * BumpContext is a memory context that never frees individual chunks.
+ */
+typedef struct BumpContext
+{
+	MemoryContextData header;	/* Standard memory-context fields */
+
+	/* Bump context parameters */
+	Size		initBlockSize;	/* initial block size */
+	Size		maxBlockSize;	/* maximum block size */
+	Size		nextBlockSize;	/* next block size to allocate */
+	Size		allocChunkLimit;	/* effective chunk size limit */
+
+	dlist_head	blocks;			/* list of blocks, current block at head */
+	BumpBlock  *keeper;			/* keep this block over resets */
+} BumpContext;
+
+/*
+ * BumpBlock
+ *		BumpBlock is the unit of memory that is obtained by bump.c from
+ *		malloc().  It contains one or more chunks, which are carved off the
+ *		front of its free space and only released when the block is.
+ *
+ *		BumpBlock is the header data for a block --- the usable space within
+ *		the block begins at the next alignment boundary.
+ */
+struct BumpBlock
+{
+	dlist_node	node;			/* doubly-linked list of blocks */
+	char	   *freeptr;		/* start of free space in this block */
+	char	   *endptr;			/* end of space in this block */
+};
+
+#ifdef MEMORY_CONTEXT_CHECKING
+/*
+ * BumpChunk
+ *		The prefix of each piece of memory in a BumpBlock, only present in
+ *		MEMORY_CONTEXT_CHECKING builds.
+ *
+ * As in the other context types, the "context" link must be immediately
+ * adjacent to the payload area (cf. GetMemoryChunkContext), so that pfree()
+ * and friends can find BumpFree() etc. and complain.
+ */
+typedef struct BumpChunk
+{
+	/* size is always the size of the usable space in the chunk */
+	Size		size;
+	/* the size that was actually requested */
+	Size		requested_size;
+
+#define BUMPCHUNK_RAWSIZE  (SIZEOF_SIZE_T * 2 + SIZEOF_VOID_P)
+
+	/* ensure proper alignment by adding padding if needed */
+#if (BUMPCHUNK_RAWSIZE % MAXIMUM_ALIGNOF) != 0
+	char		padding[MAXIMUM_ALIGNOF - BUMPCHUNK_RAWSIZE % MAXIMUM_ALIGNOF];
+#endif
+
+	BumpContext *context;		/* owning context */
+	/* there must not be any padding to reach a MAXALIGN boundary here! */
+} BumpChunk;
+
+/*
+ * Only the "context" field should be accessed outside this module.
+ */
+#define BUMPCHUNK_PRIVATE_LEN	offsetof(BumpChunk, context)
+#endif							/* MEMORY_CONTEXT_CHECKING */
+
+/*
+ * BumpIsValid
+ *		True iff set is valid bump context.
+ */
+#define BumpIsValid(set) PointerIsValid(set)
+
+#define BumpBlockIsEmpty(block) \
+	((block)->freeptr == ((char *) (block)) + Bump_BLOCKHDRSZ)
+
+/*
+ * These functions implement the MemoryContext API for Bump contexts.
+ */
+static void *BumpAlloc(MemoryContext context, Size size);
+static void BumpFree(MemoryContext context, void *pointer);
+static void *BumpRealloc(MemoryContext context, void *pointer, Size size);
+static void BumpReset(MemoryContext context);
+static void BumpDelete(MemoryContext context);
+static Size BumpGetChunkSpace(MemoryContext context, void *pointer);
+static bool BumpIsEmpty(MemoryContext context);
+static void BumpStats(MemoryContext context,
+					  MemoryStatsPrintFunc printfunc, void *passthru,
+					  MemoryContextCounters *totals);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+static void BumpCheck(MemoryContext context);
+#endif
+
+/*
+ * This is the virtual function table for Bump contexts.
+ */
+static const MemoryContextMethods BumpMethods = {
+	BumpAlloc,
+	BumpFree,
+	BumpRealloc,
+	BumpReset,
+	BumpDelete,
+	BumpGetChunkSpace,
+	BumpIsEmpty,
+	BumpStats
+#ifdef MEMORY_CONTEXT_CHECKING
+	,BumpCheck
+#endif
+};
+
+
+/*
+ * Public routines
+ */
+
+
+/*
+ * BumpContextCreate
+ *		Create a new Bump context.
+ *
+ * parent: parent context, or NULL if top-level context
+ * name: name of context (must be statically allocated)
+ * minContextSize: minimum context size
+ * initBlockSize: initial allocation block size
+ * maxBlockSize: maximum allocation block size
+ *
+ * The size parameters have the same meaning as for AllocSetContextCreate,
+ * so callers can use macros such as ALLOCSET_DEFAULT_SIZES.
+ */
+MemoryContext
+BumpContextCreate(MemoryContext parent,
+				  const char *name,
+				  Size minContextSize,
+				  Size initBlockSize,
+				  Size maxBlockSize)
+{
+	Size		firstBlockSize;
+	BumpContext *set;
+	BumpBlock  *block;
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Assert we padded BumpChunk properly */
+	StaticAssertStmt(Bump_CHUNKHDRSZ == MAXALIGN(Bump_CHUNKHDRSZ),
+					 "sizeof(BumpChunk) is not maxaligned");
+	StaticAssertStmt(offsetof(BumpChunk, context) + sizeof(MemoryContext) ==
+					 Bump_CHUNKHDRSZ,
+					 "padding calculation in BumpChunk is wrong");
+#endif
+
+	/*
+	 * First, validate allocation parameters.  As in aset.c, Asserts seem
+	 * sufficient because nobody varies their parameters at runtime.
+	 */
+	Assert(initBlockSize == MAXALIGN(initBlockSize) &&
+		   initBlockSize >= 1024);
+	Assert(maxBlockSize == MAXALIGN(maxBlockSize) &&
+		   maxBlockSize >= initBlockSize &&
+		   AllocHugeSizeIsValid(maxBlockSize)); /* must be safe to double */
+	Assert(minContextSize == 0 ||
+		   (minContextSize == MAXALIGN(minContextSize) &&
+			minContextSize >= 1024 &&
+			minContextSize <= maxBlockSize));
+
+	/* Determine size of initial block */
+	firstBlockSize = MAXALIGN(sizeof(BumpContext)) + Bump_BLOCKHDRSZ +
+		Bump_CHUNKHDRSZ;
+	if (minContextSize != 0)
+		firstBlockSize = Max(firstBlockSize, minContextSize);
+	else
+		firstBlockSize = Max(firstBlockSize, initBlockSize);
+
+	/*
+	 * Allocate the initial block.  It starts with the context header and its
+	 * block header follows that.
+	 */
+	set = (BumpContext *) malloc(firstBlockSize);
+	if (set == NULL)
+	{
+		if (TopMemoryContext)
+			MemoryContextStats(TopMemoryContext);
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed while creating memory context \"%s\".",
+						   name)));
+	}
+
+	/*
+	 * Avoid writing code that can fail between here and MemoryContextCreate;
+	 * we'd leak the header/initial block if we ereport in this stretch.
+	 */
+
+	/* Fill in the initial block's block header */
+	block = (BumpBlock *) (((char *) set) + MAXALIGN(sizeof(BumpContext)));
+	block->freeptr = ((char *) block) + Bump_BLOCKHDRSZ;
+	block->endptr = ((char *) set) + firstBlockSize;
+
+	/* Mark unallocated space NOACCESS; leave the block header alone. */
+	VALGRIND_MAKE_MEM_NOACCESS(block->freeptr, block->endptr - block->freeptr);
+
+	/* Remember block as part of block list, and as the keeper */
+	dlist_init(&set->blocks);
+	dlist_push_head(&set->blocks, &block->node);
+	set->keeper = block;
+
+	/* Finish filling in bump-specific parts of the context header */
+	set->initBlockSize = initBlockSize;
+	set->maxBlockSize = maxBlockSize;
+	set->nextBlockSize = initBlockSize;
+
+	/*
+	 * Compute the allocation chunk size limit for this context.  Requests
+	 * exceeding it get a block of their own, so that we don't waste a large
+	 * part of a block when a big request doesn't fit in the current one.
+	 */
+	set->allocChunkLimit = maxBlockSize;
+	while ((Size) (set->allocChunkLimit + Bump_CHUNKHDRSZ) >
+		   (Size) ((maxBlockSize - Bump_BLOCKHDRSZ) / BUMP_CHUNK_FRACTION))
+		set->allocChunkLimit >>= 1;
+
+	/* Finally, do the type-independent part of context creation */
+	MemoryContextCreate((MemoryContext) set,
+						T_BumpContext,
+						&BumpMethods,
+						parent,
+						name);
+
+	MemoryContextAccountAlloc((MemoryContext) set, firstBlockSize);
+
+	return (MemoryContext) set;
+}
+
+/*
+ * BumpReset
+ *		Frees all memory which is allocated in the given set.
+ *
+ * All blocks except the keeper are returned to malloc(); the keeper is just
+ * emptied.  We also restore the initial block size.
+ */
+static void
+BumpReset(MemoryContext context)
+{
+	BumpContext *set = (BumpContext *) context;
+	dlist_mutable_iter miter;
+
+	AssertArg(BumpIsValid(set));
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Check for corruption and leaks before freeing */
+	BumpCheck(context);
+#endif
+
+	dlist_foreach_modify(miter, &set->blocks)
+	{
+		BumpBlock  *block = dlist_container(BumpBlock, node, miter.cur);
+
+		if (block == set->keeper)
+		{
+			/* Reset the block, but don't return it to malloc */
+			char	   *datastart = ((char *) block) + Bump_BLOCKHDRSZ;
+
+#ifdef CLOBBER_FREED_MEMORY
+			wipe_mem(datastart, block->freeptr - datastart);
+#else
+			/* wipe_mem() would have done this */
+			VALGRIND_MAKE_MEM_NOACCESS(datastart, block->freeptr - datastart);
+#endif
+			block->freeptr = datastart;
+		}
+		else
+		{
+			dlist_delete(miter.cur);
+
+			MemoryContextAccountFree(context,
+									 block->endptr - ((char *) block));
+
+#ifdef CLOBBER_FREED_MEMORY
+			wipe_mem(block, block->freeptr - ((char *) block));
+#endif
+			free(block);
+		}
+	}
+
+	Assert(dlist_head_element(BumpBlock, node, &set->blocks) == set->keeper);
+
+	/* Reset block size allocation sequence, too */
+	set->nextBlockSize = set->initBlockSize;
+}
+
+/*
+ * BumpDelete
+ *		Free all memory which is allocated in the given context.
+ */
+static void
+BumpDelete(MemoryContext context)
+{
+	/* Reset to release all releasable BumpBlocks */
+	BumpReset(context);
+	/* And free the context header and keeper block */
+	MemoryContextAccountFree(context, context->mem_allocated);
+	free(context);
+}
+
+/*
+ * BumpAlloc
+ *		Returns pointer to allocated memory of given size or NULL if
+ *		request could not be completed; memory is added to the set.
+ *
+ * No request may exceed:
+ *		MAXALIGN_DOWN(SIZE_MAX) - Bump_BLOCKHDRSZ - Bump_CHUNKHDRSZ
+ * All callers use a much-lower limit.
+ *
+ * Note: when using valgrind, it doesn't matter how the returned allocation
+ * is marked, as mcxt.c will set it to UNDEFINED.
+ */
+static void *
+BumpAlloc(MemoryContext context, Size size)
+{
+	BumpContext *set = (BumpContext *) context;
+	BumpBlock  *block;
+	char	   *ptr;
+	Size		chunk_size = MAXALIGN(size);
+	Size		required_size = chunk_size + Bump_CHUNKHDRSZ;
+
+	AssertArg(BumpIsValid(set));
+
+	/*
+	 * If requested size exceeds maximum for chunks, allocate an entire block
+	 * for this request.  We add it at the tail of the block list, so that
+	 * the current block stays at the head.
+	 */
+	if (chunk_size > set->allocChunkLimit)
+	{
+		Size		blksize = required_size + Bump_BLOCKHDRSZ;
+
+		block = (BumpBlock *) malloc(blksize);
+		if (block == NULL)
+			return NULL;
+
+		MemoryContextAccountAlloc(context, blksize);
+
+		/* the block is completely full */
+		block->freeptr = block->endptr = ((char *) block) + blksize;
+
+		dlist_push_tail(&set->blocks, &block->node);
+
+		ptr = ((char *) block) + Bump_BLOCKHDRSZ;
+	}
+	else
+	{
+		/*
+		 * Is there enough space in the current block?  If not, allocate a
+		 * new one.  Whatever space is left in the old block is wasted; since
+		 * requests are at most 1/8th of maxBlockSize, that's not much once
+		 * the block size has ramped up.
+		 */
+		block = dlist_head_element(BumpBlock, node, &set->blocks);
+
+		if ((Size) (block->endptr - block->freeptr) < required_size)
+		{
+			Size		blksize;
+			Size		required_blksize;
+
+			/*
+			 * The first such block has size initBlockSize, and we double the
+			 * space in each succeeding block, but not more than maxBlockSize.
+			 */
+			blksize = set->nextBlockSize;
+			set->nextBlockSize <<= 1;
+			if (set->nextBlockSize > set->maxBlockSize)
+				set->nextBlockSize = set->maxBlockSize;
+
+			/* If initBlockSize is for some reason too small, double it */
+			required_blksize = required_size + Bump_BLOCKHDRSZ;
+			while (blksize < required_blksize)
+				blksize <<= 1;
+
+			block = (BumpBlock *) malloc(blksize);
+			if (block == NULL)
+				return NULL;
+
+			MemoryContextAccountAlloc(context, blksize);
+
+			block->freeptr = ((char *) block) + Bump_BLOCKHDRSZ;
+			block->endptr = ((char *) block) + blksize;
+
+			/* Mark unallocated space NOACCESS. */
+			VALGRIND_MAKE_MEM_NOACCESS(block->freeptr,
+									   blksize - Bump_BLOCKHDRSZ);
+
+			/* Make it the current block */
+			dlist_push_head(&set->blocks, &block->node);
+		}
+
+		Assert((Size) (block->endptr - block->freeptr) >= required_size);
+
+		ptr = block->freeptr;
+		block->freeptr += required_size;
+	}
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	{
+		BumpChunk  *chunk = (BumpChunk *) ptr;
+
+		/* Prepare to initialize the chunk header. */
+		VALGRIND_MAKE_MEM_UNDEFINED(chunk, Bump_CHUNKHDRSZ);
+
+		chunk->size = chunk_size;
+		chunk->requested_size = size;
+		chunk->context = set;
+		/* set mark to catch clobber of "unused" space */
+		if (size < chunk_size)
+			set_sentinel(ptr + Bump_CHUNKHDRSZ, size);
+
+		/* Disallow external access to private part of chunk header. */
+		VALGRIND_MAKE_MEM_NOACCESS(chunk, BUMPCHUNK_PRIVATE_LEN);
+	}
+#endif
+	ptr += Bump_CHUNKHDRSZ;
+
+#ifdef RANDOMIZE_ALLOCATED_MEMORY
+	/* fill the allocated space with junk */
+	randomize_mem(ptr, size);
+#endif
+
+	/* Ensure any padding bytes are marked NOACCESS. */
+	VALGRIND_MAKE_MEM_NOACCESS(ptr + size, chunk_size - size);
+
+	return ptr;
+}
+
+/*
+ * BumpFree
+ *		Unsupported.
+ *
+ * This (and BumpRealloc and BumpGetChunkSpace) can only be reached in
+ * MEMORY_CONTEXT_CHECKING builds, since otherwise there's no chunk header to
+ * lead mcxt.c here.
+ */
+static void
+BumpFree(MemoryContext context, void *pointer)
+{
+	elog(ERROR, "pfree is not supported by the bump memory allocator");
+}
+
+/*
+ * BumpRealloc
+ *		Unsupported.
+ */
+static void *
+BumpRealloc(MemoryContext context, void *pointer, Size size)
+{
+	elog(ERROR, "repalloc is not supported by the bump memory allocator");
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * BumpGetChunkSpace
+ *		Unsupported.
+ */
+static Size
+BumpGetChunkSpace(MemoryContext context, void *pointer)
+{
+	elog(ERROR, "GetMemoryChunkSpace is not supported by the bump memory allocator");
+	return 0;					/* keep compiler quiet */
+}
+
+/*
+ * BumpIsEmpty
+ *		Is a BumpContext empty of any allocated space?
+ */
+static bool
+BumpIsEmpty(MemoryContext context)
+{
+	BumpContext *set = (BumpContext *) context;
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &set->blocks)
+	{
+		BumpBlock  *block = dlist_container(BumpBlock, node, iter.cur);
+
+		if (!BumpBlockIsEmpty(block))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * BumpStats
+ *		Compute stats about memory consumption of a Bump context.
+ *
+ * printfunc: if not NULL, pass a human-readable stats string to this.
+ * passthru: pass this pointer through to printfunc.
+ * totals: if not NULL, add stats about this context into *totals.
+ *
+ * We don't know the number of chunks, so we report none; "free" is the
+ * unused space at the end of each block.
+ */
+static void
+BumpStats(MemoryContext context,
+		  MemoryStatsPrintFunc printfunc, void *passthru,
+		  MemoryContextCounters *totals)
+{
+	BumpContext *set = (BumpContext *) context;
+	Size		nblocks = 0;
+	Size		totalspace = 0;
+	Size		freespace = 0;
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &set->blocks)
+	{
+		BumpBlock  *block = dlist_container(BumpBlock, node, iter.cur);
+
+		nblocks++;
+		if (block == set->keeper)
+		{
+			/* the keeper block shares its malloc chunk with the context */
+			totalspace += block->endptr - ((char *) set);
+		}
+		else
+			totalspace += block->endptr - ((char *) block);
+		freespace += block->endptr - block->freeptr;
+	}
+
+	if (printfunc)
+	{
+		char		stats_string[200];
+
+		snprintf(stats_string, sizeof(stats_string),
+				 "%zu total in %zd blocks; %zu free; %zu used",
+				 totalspace, nblocks, freespace, totalspace - freespace);
+		printfunc(context, passthru, stats_string);
+	}
+
+	if (totals)
+	{
+		totals->nblocks += nblocks;
+		totals->totalspace += totalspace;
+		totals->freespace += freespace;
+	}
+}
+
+
+#ifdef MEMORY_CONTEXT_CHECKING
+
+/*
+ * BumpCheck
+ *		Walk through chunks and check consistency of memory.
+ *
+ * NOTE: report errors as WARNING, *not* ERROR or FATAL.  Otherwise you'll
+ * find yourself in an infinite loop when trouble occurs, because this
+ * routine will be entered again when elog cleanup tries to release memory!
+ */
+static void
+BumpCheck(MemoryContext context)
+{
+	BumpContext *bump = (BumpContext *) context;
+	const char *name = context->name;
+	dlist_iter	iter;
+
+	/* the keeper block is always in the list */
+	if (dlist_is_empty(&bump->blocks))
+		elog(WARNING, "problem in Bump %s: keeper block is missing", name);
+
+	/* walk all blocks in this context */
+	dlist_foreach(iter, &bump->blocks)
+	{
+		BumpBlock  *block = dlist_container(BumpBlock, node, iter.cur);
+		char	   *ptr = ((char *) block) + Bump_BLOCKHDRSZ;
+
+		if (block->freeptr > block->endptr)
+			elog(WARNING, "problem in Bump %s: free pointer past end of block %p",
+				 name, block);
+
+		while (ptr < block->freeptr)
+		{
+			BumpChunk  *chunk = (BumpChunk *) ptr;
+
+			/* Allow access to private part of chunk header. */
+			VALGRIND_MAKE_MEM_DEFINED(chunk, BUMPCHUNK_PRIVATE_LEN);
+
+			/* move to the next chunk */
+			ptr += Bump_CHUNKHDRSZ + chunk->size;
+
+			if (chunk->context != bump)
+				elog(WARNING, "problem in Bump %s: bogus context link in block %p, chunk %p",
+					 name, block, chunk);
+
+			if (chunk->size < chunk->requested_size ||
+				chunk->size != MAXALIGN(chunk->size))
+				elog(WARNING, "problem in Bump %s: bogus chunk size in block %p, chunk %p",
+					 name, block, chunk);
+
+			/* check sentinel */
+			if (chunk->requested_size < chunk->size &&
+				!sentinel_ok(chunk, Bump_CHUNKHDRSZ + chunk->requested_size))
+				elog(WARNING, "problem in Bump %s: detected write past chunk end in block %p, chunk %p",
+					 name, block, chunk);
+
+			VALGRIND_MAKE_MEM_NOACCESS(chunk, BUMPCHUNK_PRIVATE_LEN);
+		}
+	}
+}
+
+#endif							/* MEMORY_CONTEXT_CHECKING */
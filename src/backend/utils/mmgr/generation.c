@@ -25,9 +25,9 @@
  *	chunks allocated in the same block have similar lifespan, this works
  *	very well and is very cheap.
  *
- *	The current implementation only uses a fixed block size - maybe it should
- *	adapt a min/max block size range, and grow the blocks automatically.
- *	It already uses dedicated blocks for oversized chunks.
+ *	Blocks start at initBlockSize and double in size up to maxBlockSize, so
+ *	that a context that only ever holds a few chunks doesn't malloc() a large
+ *	block.  Oversized chunks get dedicated blocks.
  *
  *	XXX It might be possible to improve this by keeping a small freelist for
  *	only a small number of recent blocks, but it's not clear it's worth the
@@ -60,7 +60,9 @@ typedef struct GenerationContext
 	MemoryContextData header;	/* Standard memory-context fields */
 
 	/* Generational context parameters */
-	Size		blockSize;		/* standard block size */
+	Size		initBlockSize;	/* initial block size */
+	Size		maxBlockSize;	/* maximum block size */
+	Size		nextBlockSize;	/* next block size to allocate */
 
 	GenerationBlock *block;		/* current (most recently allocated) block */
 	dlist_head	blocks;			/* list of blocks */
@@ -206,12 +208,14 @@ static const MemoryContextMethods GenerationMethods = {
  *
  * parent: parent context, or NULL if top-level context
  * name: name of context (must be statically allocated)
- * blockSize: generation block size
+ * initBlockSize: initial allocation block size
+ * maxBlockSize: maximum allocation block size
  */
 MemoryContext
 GenerationContextCreate(MemoryContext parent,
 						const char *name,
-						Size blockSize)
+						Size initBlockSize,
+						Size maxBlockSize)
 {
 	GenerationContext *set;
 
@@ -228,11 +232,15 @@ GenerationContextCreate(MemoryContext parent,
 	 * somewhat arbitrarily enforce a minimum 1K block size, mostly because
 	 * that's what AllocSet does.
 	 */
-	if (blockSize != MAXALIGN(blockSize) ||
-		blockSize < 1024 ||
-		!AllocHugeSizeIsValid(blockSize))
-		elog(ERROR, "invalid blockSize for memory context: %zu",
-			 blockSize);
+	if (initBlockSize != MAXALIGN(initBlockSize) ||
+		initBlockSize < 1024)
+		elog(ERROR, "invalid initBlockSize for memory context: %zu",
+			 initBlockSize);
+	if (maxBlockSize != MAXALIGN(maxBlockSize) ||
+		maxBlockSize < initBlockSize ||
+		!AllocHugeSizeIsValid(maxBlockSize))	/* must be safe to double */
+		elog(ERROR, "invalid maxBlockSize for memory context: %zu",
+			 maxBlockSize);
 
 	/*
 	 * Allocate the context header.  Unlike aset.c, we never try to combine
@@ -257,7 +265,9 @@ GenerationContextCreate(MemoryContext parent,
 	 */
 
 	/* Fill in GenerationContext-specific header fields */
-	set->blockSize = blockSize;
+	set->initBlockSize = initBlockSize;
+	set->maxBlockSize = maxBlockSize;
+	set->nextBlockSize = initBlockSize;
 	set->block = NULL;
 	dlist_init(&set->blocks);
 
@@ -268,6 +278,9 @@ GenerationContextCreate(MemoryContext parent,
 						parent,
 						name);
 
+	MemoryContextAccountAlloc((MemoryContext) set,
+							  MAXALIGN(sizeof(GenerationContext)));
+
 	return (MemoryContext) set;
 }
 
@@ -297,6 +310,8 @@ GenerationReset(MemoryContext context)
 
 		dlist_delete(miter.cur);
 
+		MemoryContextAccountFree(context, block->blksize);
+
 #ifdef CLOBBER_FREED_MEMORY
 		wipe_mem(block, block->blksize);
 #endif
@@ -306,6 +321,9 @@ GenerationReset(MemoryContext context)
 
 	set->block = NULL;
 
+	/* Reset block size allocation sequence, too */
+	set->nextBlockSize = set->initBlockSize;
+
 	Assert(dlist_is_empty(&set->blocks));
 }
 
@@ -319,6 +337,7 @@ GenerationDelete(MemoryContext context)
 	/* Reset to release all the GenerationBlocks */
 	GenerationReset(context);
 	/* And free the context header */
+	MemoryContextAccountFree(context, context->mem_allocated);
 	free(context);
 }
 
@@ -344,7 +363,7 @@ GenerationAlloc(MemoryContext context, Size size)
 	Size		chunk_size = MAXALIGN(size);
 
 	/* is it an over-sized chunk? if yes, allocate special block */
-	if (chunk_size > set->blockSize / 8)
+	if (chunk_size > set->maxBlockSize / 8)
 	{
 		Size		blksize = chunk_size + Generation_BLOCKHDRSZ + Generation_CHUNKHDRSZ;
 
@@ -352,6 +371,8 @@ GenerationAlloc(MemoryContext context, Size size)
 		if (block == NULL)
 			return NULL;
 
+		MemoryContextAccountAlloc(context, blksize);
+
 		/* block with a single (used) chunk */
 		block->blksize = blksize;
 		block->nchunks = 1;
@@ -400,13 +421,31 @@ GenerationAlloc(MemoryContext context, Size size)
 	if ((block == NULL) ||
 		(block->endptr - block->freeptr) < Generation_CHUNKHDRSZ + chunk_size)
 	{
-		Size		blksize = set->blockSize;
+		Size		blksize;
+		Size		required_blksize;
+
+		/*
+		 * The first such block has size initBlockSize, and we double the
+		 * space in each succeeding block, but not more than maxBlockSize.
+		 */
+		blksize = set->nextBlockSize;
+		set->nextBlockSize <<= 1;
+		if (set->nextBlockSize > set->maxBlockSize)
+			set->nextBlockSize = set->maxBlockSize;
+
+		/* If initBlockSize is for some reason too small, double it */
+		required_blksize = Generation_BLOCKHDRSZ + Generation_CHUNKHDRSZ +
+			chunk_size;
+		while (blksize < required_blksize)
+			blksize <<= 1;
 
 		block = (GenerationBlock *) malloc(blksize);
 
 		if (block == NULL)
 			return NULL;
 
+		MemoryContextAccountAlloc(context, blksize);
+
 		block->blksize = blksize;
 		block->nchunks = 0;
 		block->nfree = 0;
@@ -512,16 +551,30 @@ GenerationFree(MemoryContext context, void *pointer)
 	if (block->nfree < block->nchunks)
 		return;
 
+	/*
+	 * If the empty block is the current allocation block, just rewind it.
+	 * Freeing it would only make the next allocation malloc() a new one,
+	 * which is expensive when allocations and frees alternate.
+	 */
+	if (set->block == block)
+	{
+		block->nchunks = 0;
+		block->nfree = 0;
+		block->freeptr = ((char *) block) + Generation_BLOCKHDRSZ;
+
+		/* Mark unallocated space NOACCESS. */
+		VALGRIND_MAKE_MEM_NOACCESS(block->freeptr,
+								   block->endptr - block->freeptr);
+		return;
+	}
+
 	/*
 	 * The block is empty, so let's get rid of it. First remove it from the
 	 * list of blocks, then return it to malloc().
 	 */
 	dlist_delete(&block->node);
 
-	/* Also make sure the block is not marked as the current block. */
-	if (set->block == block)
-		set->block = NULL;
-
+	MemoryContextAccountFree(context, block->blksize);
 	free(block);
 }
 
@@ -667,8 +720,18 @@ static bool
 GenerationIsEmpty(MemoryContext context)
 {
 	GenerationContext *set = (GenerationContext *) context;
+	dlist_iter	iter;
+
+	/* The current block is kept even after all its chunks are freed */
+	dlist_foreach(iter, &set->blocks)
+	{
+		GenerationBlock *block = dlist_container(GenerationBlock, node, iter.cur);
+
+		if (block->nchunks > 0)
+			return false;
+	}
 
-	return dlist_is_empty(&set->blocks);
+	return true;
 }
 
 /*
@@ -757,9 +820,12 @@ GenerationCheck(MemoryContext context)
 
 		/*
 		 * nfree > nchunks is surely wrong, and we don't expect to see
-		 * equality either, because such a block should have gotten freed.
+		 * equality either, because such a block should have gotten freed ---
+		 * unless it's an empty current block, which gets rewound instead.
 		 */
-		if (block->nfree >= block->nchunks)
+		if (block->nfree > block->nchunks ||
+			(block->nfree == block->nchunks &&
+			 !(block == gen->block && block->nchunks == 0)))
 			elog(WARNING, "problem in Generation %s: number of free chunks %d in block %p exceeds %d allocated",
 				 name, block->nfree, block, block->nchunks);
 
@@ -284,6 +284,8 @@ SlabContextCreate(MemoryContext parent,
 						parent,
 						name);
 
+	MemoryContextAccountAlloc((MemoryContext) slab, headerSize);
+
 	return (MemoryContext) slab;
 }
 
@@ -323,6 +325,7 @@ SlabReset(MemoryContext context)
 #endif
 			free(block);
 			slab->nblocks--;
+			MemoryContextAccountFree(context, slab->blockSize);
 		}
 	}
 
@@ -341,6 +344,7 @@ SlabDelete(MemoryContext context)
 	/* Reset to release all the SlabBlocks */
 	SlabReset(context);
 	/* And free the context header */
+	MemoryContextAccountFree(context, context->mem_allocated);
 	free(context);
 }
 
@@ -381,6 +385,8 @@ SlabAlloc(MemoryContext context, Size size)
 		if (block == NULL)
 			return NULL;
 
+		MemoryContextAccountAlloc(context, slab->blockSize);
+
 		block->nfree = slab->chunksPerBlock;
 		block->firstFreeChunk = 0;
 
@@ -573,6 +579,7 @@ SlabFree(MemoryContext context, void *pointer)
 	{
 		free(block);
 		slab->nblocks--;
+		MemoryContextAccountFree(context, slab->blockSize);
 	}
 	else
 		dlist_push_head(&slab->freelist[block->nfree], &block->node);
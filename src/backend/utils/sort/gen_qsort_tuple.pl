@@ -53,6 +53,19 @@ print <<'EOM';
 EOM
 emit_qsort_implementation();
 
+# Variants for sorts whose leading key has one of the ssup_datum_*_cmp
+# comparators; cmp_tuple_xxx() are defined in tuplesort.c.
+foreach my $type ('unsigned', 'signed', 'int32')
+{
+	$SUFFIX      = "tuple_$type";
+	$EXTRAARGS   = ', Tuplesortstate *state';
+	$EXTRAPARAMS = ', state';
+	$CMPPARAMS   = ', state';
+	print "\n#ifdef USE_FLOAT8_BYVAL\n" if $type eq 'signed';
+	emit_qsort_implementation();
+	print "#endif\n" if $type eq 'signed';
+}
+
 sub emit_qsort_boilerplate
 {
 	print <<'EOM';
@@ -47,14 +47,26 @@
  *
  * To further make the I/Os more sequential, we can use a larger buffer
  * when reading, and read multiple blocks from the same tape in one go,
- * whenever the buffer becomes empty.
+ * whenever the buffer becomes empty.  Each time a tape's buffer is
+ * refilled, we also ask the kernel to start reading the blocks that will
+ * fill it next time, so that a merge over many tapes doesn't stall on one
+ * synchronous read after another.
  *
- * To support the above policy of writing to the lowest free block,
- * ltsGetFreeBlock sorts the list of free block numbers into decreasing
- * order each time it is asked for a block and the list isn't currently
- * sorted.  This is an efficient way to handle it because we expect cycles
- * of releasing many blocks followed by re-using many blocks, due to
- * the larger read buffer.
+ * That read-ahead only helps if a tape's blocks are mostly adjacent on
+ * disk.  When many tapes are written at the same time (as happens while
+ * merging), handing out free blocks one at a time would interleave them.
+ * So each tape being written grabs a batch of free blocks at a time, and
+ * uses them in order.  The batch grows as the tape grows, up to
+ * TAPE_WRITE_PREALLOC_MAX blocks.  Only blocks already on the free list are
+ * reserved this way; when it is empty, the tape extends the file one block
+ * at a time.  Reserving blocks past the end of file would leave a gap that
+ * has to be zero-filled as soon as another tape writes beyond it, and then
+ * written again.
+ *
+ * To support the above policy of writing to the lowest free block, the
+ * free block numbers are kept in a min-heap, so that ltsGetFreeBlock can
+ * get the lowest one in O(log n) time no matter how allocations and
+ * releases are interleaved.
  *
  * Since all the bookkeeping and buffer memory is allocated with palloc(),
  * and the underlying file(s) are made with OpenTemporaryFile, all resources
@@ -114,6 +126,14 @@ typedef struct TapeBlockTrailer
 #define TapeBlockSetNBytes(buf, nbytes) \
 	(TapeBlockGetTrailer(buf)->next = -(nbytes))
 
+/*
+ * When a tape is being written, blocks are taken from the free list
+ * TAPE_WRITE_PREALLOC_MIN at first, doubling up to TAPE_WRITE_PREALLOC_MAX,
+ * and kept in the tape's private prealloc[] list until used.
+ */
+#define TAPE_WRITE_PREALLOC_MIN 8
+#define TAPE_WRITE_PREALLOC_MAX 128
+
 
 /*
  * This data structure represents a single "logical tape" within the set
@@ -147,6 +167,14 @@ typedef struct LogicalTape
 	long		nextBlockNumber;
 	long		offsetBlockNumber;
 
+	/*
+	 * Blocks reserved for this tape while writing, in decreasing order so
+	 * that the lowest one is at the end.
+	 */
+	long	   *prealloc;
+	int			nprealloc;		/* # of blocks remaining in prealloc[] */
+	int			prealloc_size;	/* allocated length of prealloc[] */
+
 	/*
 	 * Buffer for current data block(s).
 	 */
@@ -182,21 +210,16 @@ struct LogicalTapeSet
 	long		nHoleBlocks;	/* # of "hole" blocks left */
 
 	/*
-	 * We store the numbers of recycled-and-available blocks in freeBlocks[].
-	 * When there are no such blocks, we extend the underlying file.
+	 * We store the numbers of recycled-and-available blocks in freeBlocks[],
+	 * which is a binary min-heap.  When there are no such blocks, we extend
+	 * the underlying file.
 	 *
 	 * If forgetFreeSpace is true then any freed blocks are simply forgotten
 	 * rather than being remembered in freeBlocks[].  See notes for
 	 * LogicalTapeSetForgetFreeSpace().
-	 *
-	 * If blocksSorted is true then the block numbers in freeBlocks are in
-	 * *decreasing* order, so that removing the last entry gives us the lowest
-	 * free block.  We re-sort the blocks whenever a block is demanded; this
-	 * should be reasonably efficient given the expected usage pattern.
 	 */
 	bool		forgetFreeSpace;	/* are we remembering free blocks? */
-	bool		blocksSorted;	/* is freeBlocks[] currently in order? */
-	long	   *freeBlocks;		/* resizable array */
+	long	   *freeBlocks;		/* resizable array holding min-heap */
 	int			nFreeBlocks;	/* # of currently free blocks */
 	int			freeBlocksLen;	/* current allocated length of freeBlocks[] */
 
@@ -208,7 +231,9 @@ struct LogicalTapeSet
 static void ltsWriteBlock(LogicalTapeSet *lts, long blocknum, void *buffer);
 static void ltsReadBlock(LogicalTapeSet *lts, long blocknum, void *buffer);
 static long ltsGetFreeBlock(LogicalTapeSet *lts);
+static long ltsGetBlock(LogicalTapeSet *lts, LogicalTape *lt);
 static void ltsReleaseBlock(LogicalTapeSet *lts, long blocknum);
+static void ltsReleasePrealloc(LogicalTapeSet *lts, LogicalTape *lt);
 static void ltsConcatWorkerTapes(LogicalTapeSet *lts, TapeShare *shared,
 								 SharedFileSet *fileset);
 
@@ -231,7 +256,8 @@ ltsWriteBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
 	 * writing a run, and switches to another tape.  The last block of the
 	 * previous tape isn't flushed to disk until the end of the sort, so you
 	 * get one-block hole, where the last block of the previous tape will
-	 * later go.
+	 * later go.  (ltsGetBlock never reserves blocks past the end of file, so
+	 * batch preallocation doesn't create bigger holes.)
 	 *
 	 * Note that BufFile concatenation can leave "holes" in BufFile between
 	 * worker-owned block ranges.  These are tracked for reporting purposes
@@ -325,49 +351,100 @@ ltsReadFillBuffer(LogicalTapeSet *lts, LogicalTape *lt)
 		/* Advance to next block, if we have buffer space left */
 	} while (lt->buffer_size - lt->nbytes > BLCKSZ);
 
+	/*
+	 * Start reading the blocks we'll need for the next refill.  We don't know
+	 * where they are without following the chain, but since tapes are
+	 * written in runs of consecutive blocks, the blocks following the next
+	 * one are a good guess.  A wrong guess costs only a wasted read.
+	 */
+	if (!lt->frozen && lt->nextBlockNumber != -1L)
+		BufFilePrefetchBlock(lts->pfile,
+							 lt->nextBlockNumber + lt->offsetBlockNumber,
+							 lt->buffer_size / BLCKSZ);
+
 	return (lt->nbytes > 0);
 }
 
 /*
- * qsort comparator for sorting freeBlocks[] into decreasing order.
+ * Select the lowest currently unused block, removing it from the free list.
  */
-static int
-freeBlocks_cmp(const void *a, const void *b)
+static long
+ltsGetFreeBlock(LogicalTapeSet *lts)
 {
-	long		ablk = *((const long *) a);
-	long		bblk = *((const long *) b);
-
-	/* can't just subtract because long might be wider than int */
-	if (ablk < bblk)
-		return 1;
-	if (ablk > bblk)
-		return -1;
-	return 0;
+	long	   *heap = lts->freeBlocks;
+	long		blocknum;
+	long		holeval;
+	int			holepos;
+	int			n;
+
+	/* If there are no free blocks, assign the next block at end of file */
+	if (lts->nFreeBlocks == 0)
+		return lts->nBlocksAllocated++;
+
+	/* Take the root of the heap, and sift the last element down into it */
+	blocknum = heap[0];
+	n = --lts->nFreeBlocks;
+	if (n == 0)
+		return blocknum;
+	holeval = heap[n];
+	holepos = 0;
+	for (;;)
+	{
+		int			child = 2 * holepos + 1;
+
+		if (child >= n)
+			break;
+		if (child + 1 < n && heap[child + 1] < heap[child])
+			child++;
+		if (holeval <= heap[child])
+			break;
+		heap[holepos] = heap[child];
+		holepos = child;
+	}
+	heap[holepos] = holeval;
+
+	return blocknum;
 }
 
 /*
- * Select a currently unused block for writing to.
+ * Select a block for tape 'lt' to write to next.
+ *
+ * Blocks are taken from the free list in batches, so that the tape's blocks
+ * stay close together even if other tapes are being written concurrently.
+ * If the free list is empty, we extend the file by a single block instead;
+ * see the comments at the top of the file.
  */
 static long
-ltsGetFreeBlock(LogicalTapeSet *lts)
+ltsGetBlock(LogicalTapeSet *lts, LogicalTape *lt)
 {
-	/*
-	 * If there are multiple free blocks, we select the one appearing last in
-	 * freeBlocks[] (after sorting the array if needed).  If there are none,
-	 * assign the next block at the end of the file.
-	 */
-	if (lts->nFreeBlocks > 0)
+	int			nblocks;
+	int			i;
+
+	if (lt->nprealloc == 0)
 	{
-		if (!lts->blocksSorted)
+		if (lts->nFreeBlocks == 0)
+			return ltsGetFreeBlock(lts);
+
+		if (lt->prealloc == NULL)
+		{
+			lt->prealloc_size = TAPE_WRITE_PREALLOC_MIN;
+			lt->prealloc = (long *) palloc(sizeof(long) * lt->prealloc_size);
+		}
+		else if (lt->prealloc_size < TAPE_WRITE_PREALLOC_MAX)
 		{
-			qsort((void *) lts->freeBlocks, lts->nFreeBlocks,
-				  sizeof(long), freeBlocks_cmp);
-			lts->blocksSorted = true;
+			lt->prealloc_size *= 2;
+			lt->prealloc = (long *) repalloc(lt->prealloc,
+											 sizeof(long) * lt->prealloc_size);
 		}
-		return lts->freeBlocks[--lts->nFreeBlocks];
+
+		/* Blocks come out of the free list in increasing order */
+		nblocks = Min(lt->prealloc_size, lts->nFreeBlocks);
+		for (i = nblocks; i > 0; i--)
+			lt->prealloc[i - 1] = ltsGetFreeBlock(lts);
+		lt->nprealloc = nblocks;
 	}
-	else
-		return lts->nBlocksAllocated++;
+
+	return lt->prealloc[--lt->nprealloc];
 }
 
 /*
@@ -376,7 +453,8 @@ ltsGetFreeBlock(LogicalTapeSet *lts)
 static void
 ltsReleaseBlock(LogicalTapeSet *lts, long blocknum)
 {
-	int			ndx;
+	long	   *heap;
+	int			holepos;
 
 	/*
 	 * Do nothing if we're no longer interested in remembering free space.
@@ -394,14 +472,36 @@ ltsReleaseBlock(LogicalTapeSet *lts, long blocknum)
 											lts->freeBlocksLen * sizeof(long));
 	}
 
-	/*
-	 * Add blocknum to array, and mark the array unsorted if it's no longer in
-	 * decreasing order.
-	 */
-	ndx = lts->nFreeBlocks++;
-	lts->freeBlocks[ndx] = blocknum;
-	if (ndx > 0 && lts->freeBlocks[ndx - 1] < blocknum)
-		lts->blocksSorted = false;
+	/* Add blocknum at the end of the heap, and sift it up */
+	heap = lts->freeBlocks;
+	holepos = lts->nFreeBlocks++;
+	while (holepos > 0)
+	{
+		int			parent = (holepos - 1) / 2;
+
+		if (heap[parent] <= blocknum)
+			break;
+		heap[holepos] = heap[parent];
+		holepos = parent;
+	}
+	heap[holepos] = blocknum;
+}
+
+/*
+ * Return any blocks tape 'lt' has preallocated but not used to the freelist,
+ * once it is done writing.
+ */
+static void
+ltsReleasePrealloc(LogicalTapeSet *lts, LogicalTape *lt)
+{
+	if (lt->prealloc == NULL)
+		return;
+
+	while (lt->nprealloc > 0)
+		ltsReleaseBlock(lts, lt->prealloc[--lt->nprealloc]);
+	pfree(lt->prealloc);
+	lt->prealloc = NULL;
+	lt->prealloc_size = 0;
 }
 
 /*
@@ -531,7 +631,6 @@ LogicalTapeSetCreate(int ntapes, TapeShare *shared, SharedFileSet *fileset,
 	lts->nBlocksWritten = 0L;
 	lts->nHoleBlocks = 0L;
 	lts->forgetFreeSpace = false;
-	lts->blocksSorted = true;	/* a zero-length array is sorted ... */
 	lts->freeBlocksLen = 32;	/* reasonable initial guess */
 	lts->freeBlocks = (long *) palloc(lts->freeBlocksLen * sizeof(long));
 	lts->nFreeBlocks = 0;
@@ -553,6 +652,9 @@ LogicalTapeSetCreate(int ntapes, TapeShare *shared, SharedFileSet *fileset,
 		lt->curBlockNumber = -1L;
 		lt->nextBlockNumber = -1L;
 		lt->offsetBlockNumber = 0L;
+		lt->prealloc = NULL;
+		lt->nprealloc = 0;
+		lt->prealloc_size = 0;
 		lt->buffer = NULL;
 		lt->buffer_size = 0;
 		/* palloc() larger than MaxAllocSize would fail */
@@ -599,6 +701,8 @@ LogicalTapeSetClose(LogicalTapeSet *lts)
 		lt = &lts->tapes[i];
 		if (lt->buffer)
 			pfree(lt->buffer);
+		if (lt->prealloc)
+			pfree(lt->prealloc);
 	}
 	pfree(lts->freeBlocks);
 	pfree(lts);
@@ -647,7 +751,7 @@ LogicalTapeWrite(LogicalTapeSet *lts, int tapenum,
 		Assert(lt->firstBlockNumber == -1);
 		Assert(lt->pos == 0);
 
-		lt->curBlockNumber = ltsGetFreeBlock(lts);
+		lt->curBlockNumber = ltsGetBlock(lts, lt);
 		lt->firstBlockNumber = lt->curBlockNumber;
 
 		TapeBlockGetTrailer(lt->buffer)->prev = -1L;
@@ -671,7 +775,7 @@ LogicalTapeWrite(LogicalTapeSet *lts, int tapenum,
 			 * First allocate the next block, so that we can store it in the
 			 * 'next' pointer of this block.
 			 */
-			nextBlockNumber = ltsGetFreeBlock(lts);
+			nextBlockNumber = ltsGetBlock(lts, lt);
 
 			/* set the next-pointer and dump the current block. */
 			TapeBlockGetTrailer(lt->buffer)->next = nextBlockNumber;
@@ -763,6 +867,7 @@ LogicalTapeRewindForRead(LogicalTapeSet *lts, int tapenum, size_t buffer_size)
 			ltsWriteBlock(lts, lt->curBlockNumber, (void *) lt->buffer);
 		}
 		lt->writing = false;
+		ltsReleasePrealloc(lts, lt);
 	}
 	else
 	{
@@ -912,6 +1017,7 @@ LogicalTapeFreeze(LogicalTapeSet *lts, int tapenum, TapeShare *share)
 	}
 	lt->writing = false;
 	lt->frozen = true;
+	ltsReleasePrealloc(lts, lt);
 
 	/*
 	 * The seek and backspace functions assume a single block read buffer.
@@ -223,6 +223,16 @@ typedef enum
 #define TAPE_BUFFER_OVERHEAD		BLCKSZ
 #define MERGE_BUFFER_SIZE			(BLCKSZ * 32)
 
+/*
+ * Maximum block size for the generation.c context holding caller tuples:
+ * 1/64th of workMem, but at least ALLOCSET_DEFAULT_INITSIZE and at most
+ * ALLOCSET_DEFAULT_MAXSIZE.  Blocks start at ALLOCSET_DEFAULT_INITSIZE, so
+ * that small sorts don't malloc() a large block for a few tuples.
+ */
+#define TUPLESORT_GENERATION_MAX_BLOCK_SIZE(workMem) \
+	Min(Max((Size) (workMem) * 1024 / 64, ALLOCSET_DEFAULT_INITSIZE), \
+		ALLOCSET_DEFAULT_MAXSIZE)
+
 typedef int (*SortTupleComparator) (const SortTuple *a, const SortTuple *b,
 									Tuplesortstate *state);
 
@@ -413,6 +423,12 @@ struct Tuplesortstate
 	TupleDesc	tupDesc;
 	SortSupport sortKeys;		/* array of length nKeys */
 
+	/*
+	 * Do SortTuples' datum1 fields hold the leading sort key?  Not so for
+	 * hash indexes, or for CLUSTER on an index with a leading expression.
+	 */
+	bool		haveDatum1;
+
 	/*
 	 * This variable is shared by the single-key MinimalTuple case and the
 	 * Datum case (which both use qsort_ssup()).  Otherwise it's NULL.
@@ -648,12 +664,76 @@ static void worker_nomergeruns(Tuplesortstate *state);
 static void leader_takeover_tapes(Tuplesortstate *state);
 static void free_sort_tuple(Tuplesortstate *state, SortTuple *stup);
 
+/*
+ * Comparators for the qsort_tuple_xxx() variants: compare the leading key
+ * inline, and only call comparetup to break ties.  comparetup compares the
+ * leading key again, but that's cheap next to the work it saves.
+ */
+static pg_attribute_always_inline int
+cmp_tuple_unsigned(SortTuple *a, SortTuple *b, Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplyUnsignedSortComparator(a->datum1, a->isnull1,
+										  b->datum1, b->isnull1,
+										  &state->sortKeys[0]);
+	if (compare != 0)
+		return compare;
+
+	/* no need to call comparetup if there's only one key */
+	if (state->onlyKey != NULL)
+		return 0;
+
+	return state->comparetup(a, b, state);
+}
+
+#ifdef USE_FLOAT8_BYVAL
+static pg_attribute_always_inline int
+cmp_tuple_signed(SortTuple *a, SortTuple *b, Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplySignedSortComparator(a->datum1, a->isnull1,
+										b->datum1, b->isnull1,
+										&state->sortKeys[0]);
+	if (compare != 0)
+		return compare;
+
+	/* no need to call comparetup if there's only one key */
+	if (state->onlyKey != NULL)
+		return 0;
+
+	return state->comparetup(a, b, state);
+}
+#endif
+
+static pg_attribute_always_inline int
+cmp_tuple_int32(SortTuple *a, SortTuple *b, Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplyInt32SortComparator(a->datum1, a->isnull1,
+									   b->datum1, b->isnull1,
+									   &state->sortKeys[0]);
+	if (compare != 0)
+		return compare;
+
+	/* no need to call comparetup if there's only one key */
+	if (state->onlyKey != NULL)
+		return 0;
+
+	return state->comparetup(a, b, state);
+}
+
 /*
  * Special versions of qsort just for SortTuple objects.  qsort_tuple() sorts
  * any variant of SortTuples, using the appropriate comparetup function.
  * qsort_ssup() is specialized for the case where the comparetup function
  * reduces to ApplySortComparator(), that is single-key MinimalTuple sorts
- * and Datum sorts.
+ * and Datum sorts.  qsort_tuple_unsigned(), qsort_tuple_signed() and
+ * qsort_tuple_int32() are used when the leading key's comparator is the
+ * corresponding ssup_datum_xxx_cmp() function, whose comparisons they
+ * inline.
  */
 #include "qsort_tuple.c"
 
@@ -706,10 +786,17 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 	 * fragmentation. Note that the memtuples array of SortTuples is allocated
 	 * in the parent context, not this context, because there is no need to
 	 * free memtuples early.
+	 *
+	 * Tuples are only ever freed all at once, or in roughly the order they
+	 * were added (as runs are dumped), so we use a generation.c context: it
+	 * doesn't round each tuple up to a power of 2 the way aset.c does, which
+	 * wastes up to half of workMem on narrow tuples.  tuplesort_set_bound()
+	 * switches to aset.c, since a bounded heap frees tuples in any order.
 	 */
-	tuplecontext = AllocSetContextCreate(sortcontext,
-										 "Caller tuples",
-										 ALLOCSET_DEFAULT_SIZES);
+	tuplecontext = GenerationContextCreate(sortcontext,
+										   "Caller tuples",
+										   ALLOCSET_DEFAULT_INITSIZE,
+										   TUPLESORT_GENERATION_MAX_BLOCK_SIZE(workMem));
 
 	/*
 	 * Make the Tuplesortstate within the per-sort context.  This way, we
@@ -870,6 +957,7 @@ tuplesort_begin_heap(TupleDesc tupDesc,
 	 */
 	if (nkeys == 1 && !state->sortKeys->abbrev_converter)
 		state->onlyKey = state->sortKeys;
+	state->haveDatum1 = true;
 
 	MemoryContextSwitchTo(oldcontext);
 
@@ -917,6 +1005,9 @@ tuplesort_begin_cluster(TupleDesc tupDesc,
 
 	state->indexInfo = BuildIndexInfo(indexRel);
 
+	/* datum1 is only set if the leading key is a simple column */
+	state->haveDatum1 = (state->indexInfo->ii_IndexAttrNumbers[0] != 0);
+
 	state->tupDesc = tupDesc;	/* assume we need not copy tupDesc */
 
 	indexScanKey = _bt_mkscankey(indexRel, NULL);
@@ -1013,6 +1104,7 @@ tuplesort_begin_index_btree(Relation heapRel,
 	state->heapRel = heapRel;
 	state->indexRel = indexRel;
 	state->enforceUnique = enforceUnique;
+	state->haveDatum1 = true;
 
 	indexScanKey = _bt_mkscankey(indexRel, NULL);
 
@@ -1164,6 +1256,7 @@ tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 	 */
 	if (!state->sortKeys->abbrev_converter)
 		state->onlyKey = state->sortKeys;
+	state->haveDatum1 = true;
 
 	MemoryContextSwitchTo(oldcontext);
 
@@ -1208,6 +1301,16 @@ tuplesort_set_bound(Tuplesortstate *state, int64 bound)
 	state->bounded = true;
 	state->bound = (int) bound;
 
+	/*
+	 * The bounded heap frees tuples in no particular order, which a
+	 * generation.c context can't make good use of.  Nothing has been stored
+	 * in tuplecontext yet, so just replace it.
+	 */
+	MemoryContextDelete(state->tuplecontext);
+	state->tuplecontext = AllocSetContextCreate(state->sortcontext,
+												"Caller tuples",
+												ALLOCSET_DEFAULT_SIZES);
+
 	/*
 	 * Bounded sorts are not an effective target for abbreviated key
 	 * optimization.  Disable by setting state to be consistent with no
@@ -3000,9 +3103,7 @@ dumptuples(Tuplesortstate *state, bool alltuples)
 	/*
 	 * Reset tuple memory.  We've freed all of the tuples that we previously
 	 * allocated.  It's important to avoid fragmentation when there is a stark
-	 * change in the sizes of incoming tuples.  Fragmentation due to
-	 * AllocSetFree's bucketing by size class might be particularly bad if
-	 * this step wasn't taken.
+	 * change in the sizes of incoming tuples.
 	 */
 	MemoryContextReset(state->tuplecontext);
 
@@ -3312,6 +3413,35 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 
 	if (state->memtupcount > 1)
 	{
+		/*
+		 * Do we have a specialized sort routine for the leading key's
+		 * comparator?  These beat even qsort_ssup(), since they avoid calling
+		 * the comparator through a function pointer.
+		 */
+		if (state->haveDatum1 && state->sortKeys)
+		{
+			if (state->sortKeys[0].comparator == ssup_datum_unsigned_cmp)
+			{
+				qsort_tuple_unsigned(state->memtuples, state->memtupcount,
+									 state);
+				return;
+			}
+#ifdef USE_FLOAT8_BYVAL
+			else if (state->sortKeys[0].comparator == ssup_datum_signed_cmp)
+			{
+				qsort_tuple_signed(state->memtuples, state->memtupcount,
+								   state);
+				return;
+			}
+#endif
+			else if (state->sortKeys[0].comparator == ssup_datum_int32_cmp)
+			{
+				qsort_tuple_int32(state->memtuples, state->memtupcount,
+								  state);
+				return;
+			}
+		}
+
 		/* Can we use the single-key sort function? */
 		if (state->onlyKey != NULL)
 			qsort_ssup(state->memtuples, state->memtupcount,
@@ -4588,3 +4718,50 @@ free_sort_tuple(Tuplesortstate *state, SortTuple *stup)
 	FREEMEM(state, GetMemoryChunkSpace(stup->tuple));
 	pfree(stup->tuple);
 }
+
+/*
+ * Datum comparison functions that tuplesort_sort_memtuples() has specialized
+ * sort routines for.  Datatypes can install these as their sortsupport
+ * comparator (or abbreviated comparator) instead of an equivalent function
+ * of their own.
+ */
+int
+ssup_datum_unsigned_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	if (x < y)
+		return -1;
+	else if (x > y)
+		return 1;
+	else
+		return 0;
+}
+
+#ifdef USE_FLOAT8_BYVAL
+int
+ssup_datum_signed_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	int64		xx = DatumGetInt64(x);
+	int64		yy = DatumGetInt64(y);
+
+	if (xx < yy)
+		return -1;
+	else if (xx > yy)
+		return 1;
+	else
+		return 0;
+}
+#endif
+
+int
+ssup_datum_int32_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	int32		xx = DatumGetInt32(x);
+	int32		yy = DatumGetInt32(y);
+
+	if (xx < yy)
+		return -1;
+	else if (xx > yy)
+		return 1;
+	else
+		return 0;
+}
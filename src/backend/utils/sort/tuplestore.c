@@ -111,7 +111,8 @@ struct Tuplestorestate
 	int64		allowedMem;		/* total memory allowed, in bytes */
 	int64		tuples;			/* number of tuples added */
 	BufFile    *myfile;			/* underlying file, or NULL if none */
-	MemoryContext context;		/* memory context for holding tuples */
+	MemoryContext context;		/* memory context for holding tuplestore */
+	MemoryContext tuplecontext; /* sub-context of context for tuple data */
 	ResourceOwner resowner;		/* resowner for holding temp files */
 
 	/*
@@ -187,6 +188,16 @@ struct Tuplestorestate
 #define USEMEM(state,amt)	((state)->availMem -= (amt))
 #define FREEMEM(state,amt)	((state)->availMem += (amt))
 
+/*
+ * Maximum block size for the generation.c context holding in-memory tuples:
+ * 1/64th of maxKBytes, but at least ALLOCSET_DEFAULT_INITSIZE and at most
+ * ALLOCSET_DEFAULT_MAXSIZE.  Blocks start at ALLOCSET_DEFAULT_INITSIZE, so
+ * that small stores don't malloc() a large block for a few tuples.
+ */
+#define TUPLESTORE_GENERATION_MAX_BLOCK_SIZE(maxKBytes) \
+	Min(Max((Size) (maxKBytes) * 1024 / 64, ALLOCSET_DEFAULT_INITSIZE), \
+		ALLOCSET_DEFAULT_MAXSIZE)
+
 /*--------------------
  *
  * NOTES about on-tape representation of tuples:
@@ -229,6 +240,11 @@ struct Tuplestorestate
  * we won't count any wasted space in palloc allocation blocks, but it's
  * a lot better than what we were doing before 7.3.
  *
+ * In-memory tuples are kept in a generation.c context (tuplecontext), since
+ * they are only freed in the order they were stored (by tuplestore_trim),
+ * or all at once.  Unlike aset.c, it doesn't round each chunk up to a power
+ * of 2, so narrow tuples take up much less of maxKBytes.
+ *
  *--------------------
  */
 
@@ -264,6 +280,10 @@ tuplestore_begin_common(int eflags, bool interXact, int maxKBytes)
 	state->availMem = state->allowedMem;
 	state->myfile = NULL;
 	state->context = CurrentMemoryContext;
+	state->tuplecontext = GenerationContextCreate(CurrentMemoryContext,
+												  "Tuplestore tuples",
+												  ALLOCSET_DEFAULT_INITSIZE,
+												  TUPLESTORE_GENERATION_MAX_BLOCK_SIZE(maxKBytes));
 	state->resowner = CurrentResourceOwner;
 
 	state->memtupdeleted = 0;
@@ -426,11 +446,9 @@ tuplestore_clear(Tuplestorestate *state)
 	if (state->memtuples)
 	{
 		for (i = state->memtupdeleted; i < state->memtupcount; i++)
-		{
 			FREEMEM(state, GetMemoryChunkSpace(state->memtuples[i]));
-			pfree(state->memtuples[i]);
-		}
 	}
+	MemoryContextReset(state->tuplecontext);
 	state->status = TSS_INMEM;
 	state->truncated = false;
 	state->memtupdeleted = 0;
@@ -452,16 +470,11 @@ tuplestore_clear(Tuplestorestate *state)
 void
 tuplestore_end(Tuplestorestate *state)
 {
-	int			i;
-
 	if (state->myfile)
 		BufFileClose(state->myfile);
 	if (state->memtuples)
-	{
-		for (i = state->memtupdeleted; i < state->memtupcount; i++)
-			pfree(state->memtuples[i]);
 		pfree(state->memtuples);
-	}
+	MemoryContextDelete(state->tuplecontext);
 	pfree(state->readptrs);
 	pfree(state);
 }
@@ -709,7 +722,7 @@ tuplestore_puttupleslot(Tuplestorestate *state,
 						TupleTableSlot *slot)
 {
 	MinimalTuple tuple;
-	MemoryContext oldcxt = MemoryContextSwitchTo(state->context);
+	MemoryContext oldcxt = MemoryContextSwitchTo(state->tuplecontext);
 
 	/*
 	 * Form a MinimalTuple in working memory
@@ -729,7 +742,7 @@ tuplestore_puttupleslot(Tuplestorestate *state,
 void
 tuplestore_puttuple(Tuplestorestate *state, HeapTuple tuple)
 {
-	MemoryContext oldcxt = MemoryContextSwitchTo(state->context);
+	MemoryContext oldcxt = MemoryContextSwitchTo(state->tuplecontext);
 
 	/*
 	 * Copy the tuple.  (Must do this even in WRITEFILE case.  Note that
@@ -751,7 +764,7 @@ tuplestore_putvalues(Tuplestorestate *state, TupleDesc tdesc,
 					 Datum *values, bool *isnull)
 {
 	MinimalTuple tuple;
-	MemoryContext oldcxt = MemoryContextSwitchTo(state->context);
+	MemoryContext oldcxt = MemoryContextSwitchTo(state->tuplecontext);
 
 	tuple = heap_form_minimal_tuple(tdesc, values, isnull);
 	USEMEM(state, GetMemoryChunkSpace(tuple));
@@ -767,6 +780,7 @@ tuplestore_puttuple_common(Tuplestorestate *state, void *tuple)
 	TSReadPointer *readptr;
 	int			i;
 	ResourceOwner oldowner;
+	MemoryContext oldcxt;
 
 	state->tuples++;
 
@@ -818,8 +832,16 @@ tuplestore_puttuple_common(Tuplestorestate *state, void *tuple)
 			oldowner = CurrentResourceOwner;
 			CurrentResourceOwner = state->resowner;
 
+			/*
+			 * Our caller has switched to tuplecontext, which is a generation
+			 * context meant for tuples; the BufFile lives as long as the
+			 * store, so allocate it in the store's own context.
+			 */
+			oldcxt = MemoryContextSwitchTo(state->context);
+
 			state->myfile = BufFileCreateTemp(state->interXact);
 
+			MemoryContextSwitchTo(oldcxt);
 			CurrentResourceOwner = oldowner;
 
 			/*
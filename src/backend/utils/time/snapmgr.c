@@ -604,6 +604,9 @@ SetTransactionSnapshot(Snapshot sourcesnap, VirtualTransactionId *sourcevxid,
 	CurrentSnapshot->takenDuringRecovery = sourcesnap->takenDuringRecovery;
 	/* NB: curcid should NOT be copied, it's a local matter */
 
+	/* the contents no longer match what GetSnapshotData() computed */
+	CurrentSnapshot->snapXactCompletionCount = 0;
+
 	/*
 	 * Now we have to fix what GetSnapshotData did with MyPgXact->xmin and
 	 * TransactionXmin.  There is a race condition: to make sure we are not
@@ -679,6 +682,7 @@ CopySnapshot(Snapshot snapshot)
 	newsnap->regd_count = 0;
 	newsnap->active_count = 0;
 	newsnap->copied = true;
+	newsnap->snapXactCompletionCount = 0;
 
 	/* setup XID array */
 	if (snapshot->xcnt > 0)
@@ -1625,6 +1629,9 @@ ImportSnapshot(const char *idstr)
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("cannot import a snapshot from a different database")));
 
+	/* don't trust the file to list the xids in order */
+	SnapshotSortXids(&snapshot);
+
 	/* OK, install the snapshot */
 	SetTransactionSnapshot(&snapshot, &src_vxid, src_pid, NULL);
 }
@@ -2211,6 +2218,7 @@ RestoreSnapshot(char *start_address)
 	snapshot->regd_count = 0;
 	snapshot->active_count = 0;
 	snapshot->copied = true;
+	snapshot->snapXactCompletionCount = 0;
 
 	return snapshot;
 }
@@ -2227,6 +2235,100 @@ RestoreTransactionSnapshot(Snapshot snapshot, void *master_pgproc)
 	SetTransactionSnapshot(snapshot, NULL, InvalidPid, master_pgproc);
 }
 
+/*
+ * Arrays of at most this many xids are searched linearly, which is faster
+ * than a binary search for them.
+ */
+#define XID_LINEAR_SEARCH_MAX	16
+
+/*
+ * qsort_arg comparator for the xid arrays of a snapshot.
+ *
+ * All xids in a snapshot lie in a window starting at its xmin that is much
+ * narrower than 2^32, so their distances from xmin order them correctly even
+ * if the window spans the wraparound point.
+ */
+static int
+snapshot_xid_cmp(const void *a, const void *b, void *arg)
+{
+	TransactionId xmin = *(TransactionId *) arg;
+	uint32		dista = *(const TransactionId *) a - xmin;
+	uint32		distb = *(const TransactionId *) b - xmin;
+
+	if (dista < distb)
+		return -1;
+	if (dista > distb)
+		return 1;
+	return 0;
+}
+
+/*
+ * SnapshotSortXids
+ *		Sort the xid arrays of a newly built MVCC snapshot.
+ *
+ * Whoever fills in xip[] and subxip[] of an MVCC snapshot by other means
+ * than copying them from another such snapshot must call this, since
+ * XidInMVCCSnapshot relies on the arrays being sorted.
+ */
+void
+SnapshotSortXids(Snapshot snapshot)
+{
+	TransactionId xmin = snapshot->xmin;
+
+	if (snapshot->xcnt > XID_LINEAR_SEARCH_MAX)
+		qsort_arg(snapshot->xip, snapshot->xcnt, sizeof(TransactionId),
+				  snapshot_xid_cmp, &xmin);
+
+	/* subxip is not looked at if it overflowed, except in recovery */
+	if (snapshot->subxcnt > XID_LINEAR_SEARCH_MAX &&
+		(!snapshot->suboverflowed || snapshot->takenDuringRecovery))
+		qsort_arg(snapshot->subxip, snapshot->subxcnt, sizeof(TransactionId),
+				  snapshot_xid_cmp, &xmin);
+}
+
+/*
+ * Is xid in the given sorted array of a snapshot's xids?  xid must not
+ * precede xmin.
+ */
+static inline bool
+XidInSnapshotArray(TransactionId xid, const TransactionId *xids, uint32 nxids,
+				   TransactionId xmin)
+{
+	uint32		target;
+	uint32		low;
+	uint32		high;
+
+	if (nxids <= XID_LINEAR_SEARCH_MAX)
+	{
+		uint32		i;
+
+		for (i = 0; i < nxids; i++)
+		{
+			if (TransactionIdEquals(xid, xids[i]))
+				return true;
+		}
+		return false;
+	}
+
+	target = xid - xmin;
+	low = 0;
+	high = nxids;
+	while (low < high)
+	{
+		uint32		mid = low + (high - low) / 2;
+		uint32		dist = xids[mid] - xmin;
+
+		if (dist == target)
+			return true;
+		if (dist < target)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return false;
+}
+
 /*
  * XidInMVCCSnapshot
  *		Is the given XID still-in-progress according to the snapshot?
@@ -2240,8 +2342,6 @@ RestoreTransactionSnapshot(Snapshot snapshot, void *master_pgproc)
 bool
 XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 {
-	uint32		i;
-
 	/*
 	 * Make a quick range check to eliminate most XIDs without looking at the
 	 * xip arrays.  Note that this is OK even if we convert a subxact XID to
@@ -2273,13 +2373,9 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 		if (!snapshot->suboverflowed)
 		{
 			/* we have full data, so search subxip */
-			int32		j;
-
-			for (j = 0; j < snapshot->subxcnt; j++)
-			{
-				if (TransactionIdEquals(xid, snapshot->subxip[j]))
-					return true;
-			}
+			if (XidInSnapshotArray(xid, snapshot->subxip, snapshot->subxcnt,
+								   snapshot->xmin))
+				return true;
 
 			/* not there, fall through to search xip[] */
 		}
@@ -2300,16 +2396,12 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 				return false;
 		}
 
-		for (i = 0; i < snapshot->xcnt; i++)
-		{
-			if (TransactionIdEquals(xid, snapshot->xip[i]))
-				return true;
-		}
+		if (XidInSnapshotArray(xid, snapshot->xip, snapshot->xcnt,
+							   snapshot->xmin))
+			return true;
 	}
 	else
 	{
-		int32		j;
-
 		/*
 		 * In recovery we store all xids in the subxact array because it is by
 		 * far the bigger array, and we mostly don't know which xids are
@@ -2339,11 +2431,9 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 		 * indeterminate xid. We don't know whether it's top level or subxact
 		 * but it doesn't matter. If it's present, the xid is visible.
 		 */
-		for (j = 0; j < snapshot->subxcnt; j++)
-		{
-			if (TransactionIdEquals(xid, snapshot->subxip[j]))
-				return true;
-		}
+		if (XidInSnapshotArray(xid, snapshot->subxip, snapshot->subxcnt,
+							   snapshot->xmin))
+			return true;
 	}
 
 	return false;
@@ -95,6 +95,7 @@ static bool checksum_failure = false;
 static bool showprogress = false;
 static int	verbose = 0;
 static int	compresslevel = 0;
+static int	server_compresslevel = 0;
 static IncludeWal includewal = STREAM_WAL;
 static bool fastcheckpoint = false;
 static bool writerecoveryconf = false;
@@ -108,6 +109,7 @@ static bool temp_replication_slot = true;
 static bool create_slot = false;
 static bool no_slot = false;
 static bool verify_checksums = true;
+static XLogRecPtr incremental_lsn = InvalidXLogRecPtr;
 
 static bool success = false;
 static bool made_new_pgdata = false;
@@ -160,6 +162,7 @@ static bool reached_end_position(XLogRecPtr segendpos, uint32 timeline,
 
 static const char *get_tablespace_mapping(const char *dir);
 static void tablespace_list_append(const char *arg);
+static XLogRecPtr parse_incremental(const char *src);
 
 
 static void
@@ -334,6 +337,9 @@ usage(void)
 	printf(_("\nOptions controlling the output:\n"));
 	printf(_("  -D, --pgdata=DIRECTORY receive base backup into directory\n"));
 	printf(_("  -F, --format=p|t       output format (plain (default), tar)\n"));
+	printf(_("  -i, --incremental=LSN|DIR\n"
+			 "                         send only blocks changed since LSN, or since the\n"
+			 "                         start of the base backup in DIR\n"));
 	printf(_("  -r, --max-rate=RATE    maximum transfer rate to transfer data directory\n"
 			 "                         (in kB/s, or use suffix \"k\" or \"M\")\n"));
 	printf(_("  -R, --write-recovery-conf\n"
@@ -348,6 +354,8 @@ usage(void)
 #endif	/* USE_ENCRYPTION */
 	printf(_("  -z, --gzip             compress tar output\n"));
 	printf(_("  -Z, --compress=0-9     compress tar output with given compression level\n"));
+	printf(_("      --server-compress=1-9\n"
+			 "                         compress tar output on the server with given level\n"));
 	printf(_("\nGeneral options:\n"));
 	printf(_("  -c, --checkpoint=fast|spread\n"
 			 "                         set fast or spread checkpointing\n"));
@@ -892,6 +900,59 @@ parse_max_rate(char *src)
 	return (int32) result;
 }
 
+/*
+ * Parse the argument of --incremental: either a WAL location, or the
+ * directory of a plain-format base backup whose START WAL LOCATION is used.
+ */
+static XLogRecPtr
+parse_incremental(const char *src)
+{
+	uint32		hi,
+				lo;
+	char		dummy;
+	char		filename[MAXPGPATH];
+	char		line[MAXPGPATH];
+	FILE	   *fp;
+	XLogRecPtr	result = InvalidXLogRecPtr;
+
+	if (sscanf(src, "%X/%X%c", &hi, &lo, &dummy) == 2)
+		result = ((uint64) hi) << 32 | lo;
+	else
+	{
+		snprintf(filename, sizeof(filename), "%s/backup_label", src);
+		fp = fopen(filename, "r");
+		if (fp == NULL)
+		{
+			pg_log_error("could not open file \"%s\": %m", filename);
+			exit(1);
+		}
+		while (fgets(line, sizeof(line), fp) != NULL)
+		{
+			if (sscanf(line, "START WAL LOCATION: %X/%X", &hi, &lo) == 2)
+			{
+				result = ((uint64) hi) << 32 | lo;
+				break;
+			}
+		}
+		fclose(fp);
+
+		if (XLogRecPtrIsInvalid(result))
+		{
+			pg_log_error("could not find start WAL location in file \"%s\"",
+						 filename);
+			exit(1);
+		}
+	}
+
+	if (XLogRecPtrIsInvalid(result))
+	{
+		pg_log_error("invalid incremental backup location \"%s\"", src);
+		exit(1);
+	}
+
+	return result;
+}
+
 /*
  * Write a piece of tar data
  */
@@ -1018,7 +1079,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 			else
 #endif
 			{
-				snprintf(filename, sizeof(filename), "%s/base.tar", basedir);
+				snprintf(filename, sizeof(filename), "%s/base.tar%s", basedir,
+						 server_compresslevel != 0 ? ".gz" : "");
 				tarfile = fopen(filename, "wb");
 			}
 		}
@@ -1045,8 +1107,9 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 		else
 #endif
 		{
-			snprintf(filename, sizeof(filename), "%s/%s.tar", basedir,
-					 PQgetvalue(res, rownum, 0));
+			snprintf(filename, sizeof(filename), "%s/%s.tar%s", basedir,
+					 PQgetvalue(res, rownum, 0),
+					 server_compresslevel != 0 ? ".gz" : "");
 			tarfile = fopen(filename, "wb");
 		}
 	}
@@ -1162,7 +1225,30 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 			}
 
 			/* 2 * 512 bytes empty data at end of file */
-			WRITE_TAR_DATA(zerobuf, sizeof(zerobuf));
+#ifdef HAVE_LIBZ
+			if (server_compresslevel != 0)
+			{
+				/*
+				 * The server sent a gzip stream, which we've copied as-is.
+				 * Append the trailer as a gzip member of its own; readers
+				 * treat a series of gzip members as one stream.
+				 */
+				gzFile		ztrailer;
+
+				fflush(tarfile);
+				ztrailer = gzdopen(dup(fileno(tarfile)), "ab");
+				if (ztrailer == NULL ||
+					gzwrite(ztrailer, zerobuf, sizeof(zerobuf)) != sizeof(zerobuf) ||
+					gzclose(ztrailer) != Z_OK)
+				{
+					pg_log_error("could not write to compressed file \"%s\"",
+								 filename);
+					exit(1);
+				}
+			}
+			else
+#endif
+				WRITE_TAR_DATA(zerobuf, sizeof(zerobuf));
 
 #ifdef HAVE_LIBZ
 			if (ztarfile != NULL)
@@ -1824,6 +1910,8 @@ BaseBackup(void)
 	char	   *basebkp;
 	char		escaped_label[MAXPGPATH];
 	char	   *maxrate_clause = NULL;
+	char	   *incremental_clause = NULL;
+	char	   *compression_clause = NULL;
 	int			i;
 	char		xlogstart[64];
 	char		xlogend[64];
@@ -1885,6 +1973,14 @@ BaseBackup(void)
 	if (maxrate > 0)
 		maxrate_clause = psprintf("MAX_RATE %u", maxrate);
 
+	if (!XLogRecPtrIsInvalid(incremental_lsn))
+		incremental_clause = psprintf("INCREMENTAL '%X/%X'",
+									  (uint32) (incremental_lsn >> 32),
+									  (uint32) incremental_lsn);
+
+	if (server_compresslevel != 0)
+		compression_clause = psprintf("COMPRESSION %d", server_compresslevel);
+
 	if (verbose)
 		pg_log_info("initiating base backup, waiting for checkpoint to complete");
 
@@ -1902,7 +1998,7 @@ BaseBackup(void)
 	 * let server ignore it if the cluster is not encrypted.
 	 */
 	basebkp =
-		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s %s",
+		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s %s %s %s",
 				 escaped_label,
 				 showprogress ? "PROGRESS" : "",
 				 includewal == FETCH_WAL ? "WAL" : "",
@@ -1911,7 +2007,9 @@ BaseBackup(void)
 				 maxrate_clause ? maxrate_clause : "",
 				 format == 't' ? "TABLESPACE_MAP" : "",
 				 verify_checksums ? "" : "NOVERIFY_CHECKSUMS",
-				 decrypt ? "DECRYPT" : "");
+				 decrypt ? "DECRYPT" : "",
+				 incremental_clause ? incremental_clause : "",
+				 compression_clause ? compression_clause : "");
 
 	if (PQsendQuery(conn, basebkp) == 0)
 	{
@@ -2204,6 +2302,7 @@ main(int argc, char **argv)
 		{"format", required_argument, NULL, 'F'},
 		{"checkpoint", required_argument, NULL, 'c'},
 		{"create-slot", no_argument, NULL, 'C'},
+		{"incremental", required_argument, NULL, 'i'},
 		{"max-rate", required_argument, NULL, 'r'},
 		{"write-recovery-conf", no_argument, NULL, 'R'},
 		{"slot", required_argument, NULL, 'S'},
@@ -2229,6 +2328,7 @@ main(int argc, char **argv)
 		{"waldir", required_argument, NULL, 1},
 		{"no-slot", no_argument, NULL, 2},
 		{"no-verify-checksums", no_argument, NULL, 3},
+		{"server-compress", required_argument, NULL, 4},
 		{NULL, 0, NULL, 0}
 	};
 	int			c;
@@ -2256,7 +2356,7 @@ main(int argc, char **argv)
 
 	atexit(cleanup_directories_atexit);
 
-	while ((c = getopt_long(argc, argv, "CD:F:r:RS:T:X:l:nNyzZ:d:c:h:p:U:s:wWkvP",
+	while ((c = getopt_long(argc, argv, "CD:F:i:r:RS:T:X:l:nNyzZ:d:c:h:p:U:s:wWkvP",
 							long_options, &option_index)) != -1)
 	{
 		switch (c)
@@ -2279,6 +2379,9 @@ main(int argc, char **argv)
 					exit(1);
 				}
 				break;
+			case 'i':
+				incremental_lsn = parse_incremental(optarg);
+				break;
 			case 'r':
 				maxrate = parse_max_rate(optarg);
 				break;
@@ -2402,6 +2505,14 @@ main(int argc, char **argv)
 			case 3:
 				verify_checksums = false;
 				break;
+			case 4:
+				server_compresslevel = atoi(optarg);
+				if (server_compresslevel < 1 || server_compresslevel > 9)
+				{
+					pg_log_error("invalid compression level \"%s\"", optarg);
+					exit(1);
+				}
+				break;
 			default:
 
 				/*
@@ -2447,6 +2558,31 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (server_compresslevel != 0)
+	{
+		if (format == 'p')
+		{
+			pg_log_error("only tar mode backups can be compressed");
+			fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+					progname);
+			exit(1);
+		}
+		if (compresslevel != 0)
+		{
+			pg_log_error("--server-compress cannot be used with --gzip or --compress");
+			fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+					progname);
+			exit(1);
+		}
+		if (writerecoveryconf)
+		{
+			pg_log_error("--server-compress cannot be used with --write-recovery-conf");
+			fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+					progname);
+			exit(1);
+		}
+	}
+
 	if (format == 't' && includewal == STREAM_WAL && strcmp(basedir, "-") == 0)
 	{
 		pg_log_error("cannot stream write-ahead logs in tar mode to stdout");
@@ -2517,7 +2653,7 @@ main(int argc, char **argv)
 	}
 
 #ifndef HAVE_LIBZ
-	if (compresslevel != 0)
+	if (compresslevel != 0 || server_compresslevel != 0)
 	{
 		pg_log_error("this build does not support compression");
 		exit(1);
@@ -0,0 +1,691 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_combinebackup.c
+ *	  Reconstruct a full base backup from a full base backup and a chain
+ *	  of incremental base backups taken on top of it
+ *
+ * Copyright (c) 2010-2019, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  src/bin/pg_combinebackup/pg_combinebackup.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres_fe.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "access/xlogdefs.h"
+#include "catalog/pg_control.h"
+#include "common/controldata_utils.h"
+#include "common/file_perm.h"
+#include "common/file_utils.h"
+#include "common/logging.h"
+#include "getopt_long.h"
+#include "replication/basebackup.h"
+#include "storage/block.h"
+
+
+static const char *progname;
+static bool do_sync = true;
+static bool verbose = false;
+
+static void usage(void);
+static bool read_backup_label(const char *dir, XLogRecPtr *startlsn,
+				  XLogRecPtr *incremental_lsn);
+static void copy_file(const char *src, const char *dst);
+static void copy_directory(const char *src, const char *dst);
+static void apply_incremental_dir(const char *src, const char *dst);
+static void apply_incremental_file(const char *src, const char *dst);
+static void remove_missing(const char *src, const char *dst);
+static void strip_backup_label(const char *dir);
+static uint64 get_system_identifier(const char *dir);
+
+
+static void
+usage(void)
+{
+	printf(_("%s reconstructs a full base backup from incremental base backups.\n\n"), progname);
+	printf(_("Usage:\n"));
+	printf(_("  %s [OPTION]... FULLBACKUP INCREMENTALBACKUP...\n"), progname);
+	printf(_("\nOptions:\n"));
+	printf(_("  -o, --output=DIRECTORY  write the reconstructed backup into DIRECTORY\n"));
+	printf(_("  -N, --no-sync           do not wait for changes to be written safely to disk\n"));
+	printf(_("  -v, --verbose           output verbose messages\n"));
+	printf(_("  -V, --version           output version information, then exit\n"));
+	printf(_("  -?, --help              show this help, then exit\n"));
+	printf(_("\nThe backups must be plain-format backups, listed from oldest to newest.\n"));
+	printf(_("\nReport bugs to <pgsql-bugs@lists.postgresql.org>.\n"));
+}
+
+/*
+ * Read the start LSN of the backup in "dir", and the LSN it is incremental
+ * from, if any.  Returns false if there is no "INCREMENTAL FROM LSN" line.
+ */
+static bool
+read_backup_label(const char *dir, XLogRecPtr *startlsn,
+				  XLogRecPtr *incremental_lsn)
+{
+	char		path[MAXPGPATH];
+	char		line[MAXPGPATH];
+	FILE	   *fp;
+	uint32		hi,
+				lo;
+	bool		found_start = false;
+	bool		incremental = false;
+
+	snprintf(path, sizeof(path), "%s/backup_label", dir);
+	if ((fp = fopen(path, "r")) == NULL)
+	{
+		pg_log_error("could not open file \"%s\": %m", path);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		if (sscanf(line, "START WAL LOCATION: %X/%X", &hi, &lo) == 2)
+		{
+			*startlsn = ((uint64) hi) << 32 | lo;
+			found_start = true;
+		}
+		else if (sscanf(line, "INCREMENTAL FROM LSN: %X/%X", &hi, &lo) == 2)
+		{
+			*incremental_lsn = ((uint64) hi) << 32 | lo;
+			incremental = true;
+		}
+	}
+
+	if (ferror(fp))
+	{
+		pg_log_error("could not read file \"%s\": %m", path);
+		exit(1);
+	}
+	fclose(fp);
+
+	if (!found_start)
+	{
+		pg_log_error("could not find start WAL location in file \"%s\"", path);
+		exit(1);
+	}
+
+	return incremental;
+}
+
+/*
+ * Copy a regular file, replacing the destination if it exists.
+ */
+static void
+copy_file(const char *src, const char *dst)
+{
+	char		buf[BLCKSZ * 8];
+	int			srcfd;
+	int			dstfd;
+	int			nread;
+
+	if ((srcfd = open(src, O_RDONLY | PG_BINARY, 0)) < 0)
+	{
+		pg_log_error("could not open file \"%s\": %m", src);
+		exit(1);
+	}
+	if ((dstfd = open(dst, O_WRONLY | O_CREAT | O_TRUNC | PG_BINARY,
+					  pg_file_create_mode)) < 0)
+	{
+		pg_log_error("could not create file \"%s\": %m", dst);
+		exit(1);
+	}
+
+	while ((nread = read(srcfd, buf, sizeof(buf))) > 0)
+	{
+		errno = 0;
+		if (write(dstfd, buf, nread) != nread)
+		{
+			/* if write didn't set errno, assume problem is no disk space */
+			if (errno == 0)
+				errno = ENOSPC;
+			pg_log_error("could not write file \"%s\": %m", dst);
+			exit(1);
+		}
+	}
+	if (nread < 0)
+	{
+		pg_log_error("could not read file \"%s\": %m", src);
+		exit(1);
+	}
+
+	close(srcfd);
+	if (close(dstfd) != 0)
+	{
+		pg_log_error("could not close file \"%s\": %m", dst);
+		exit(1);
+	}
+}
+
+/*
+ * Recursively copy the full backup "src" into the (existing) directory "dst".
+ */
+static void
+copy_directory(const char *src, const char *dst)
+{
+	DIR		   *dir;
+	struct dirent *de;
+
+	if ((dir = opendir(src)) == NULL)
+	{
+		pg_log_error("could not open directory \"%s\": %m", src);
+		exit(1);
+	}
+
+	while (errno = 0, (de = readdir(dir)) != NULL)
+	{
+		char		srcpath[MAXPGPATH];
+		char		dstpath[MAXPGPATH];
+		struct stat st;
+
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+			continue;
+
+		snprintf(srcpath, sizeof(srcpath), "%s/%s", src, de->d_name);
+		snprintf(dstpath, sizeof(dstpath), "%s/%s", dst, de->d_name);
+
+		if (lstat(srcpath, &st) < 0)
+		{
+			pg_log_error("could not stat file \"%s\": %m", srcpath);
+			exit(1);
+		}
+
+		if (strncmp(de->d_name, INCREMENTAL_PREFIX,
+					INCREMENTAL_PREFIX_LENGTH) == 0)
+		{
+			pg_log_error("\"%s\" is part of an incremental backup, but the first backup must be a full backup",
+						 srcpath);
+			exit(1);
+		}
+
+		if (S_ISDIR(st.st_mode))
+		{
+			if (mkdir(dstpath, pg_dir_create_mode) != 0)
+			{
+				pg_log_error("could not create directory \"%s\": %m", dstpath);
+				exit(1);
+			}
+			copy_directory(srcpath, dstpath);
+		}
+		else if (S_ISREG(st.st_mode))
+			copy_file(srcpath, dstpath);
+		else
+		{
+			pg_log_error("\"%s\" is not a regular file or directory; tablespaces are not supported",
+						 srcpath);
+			exit(1);
+		}
+	}
+	if (errno)
+	{
+		pg_log_error("could not read directory \"%s\": %m", src);
+		exit(1);
+	}
+	closedir(dir);
+}
+
+/*
+ * Apply the incremental backup directory "src" on top of "dst".
+ */
+static void
+apply_incremental_dir(const char *src, const char *dst)
+{
+	DIR		   *dir;
+	struct dirent *de;
+
+	if ((dir = opendir(src)) == NULL)
+	{
+		pg_log_error("could not open directory \"%s\": %m", src);
+		exit(1);
+	}
+
+	while (errno = 0, (de = readdir(dir)) != NULL)
+	{
+		char		srcpath[MAXPGPATH];
+		char		dstpath[MAXPGPATH];
+		struct stat st;
+
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+			continue;
+
+		snprintf(srcpath, sizeof(srcpath), "%s/%s", src, de->d_name);
+
+		if (lstat(srcpath, &st) < 0)
+		{
+			pg_log_error("could not stat file \"%s\": %m", srcpath);
+			exit(1);
+		}
+
+		if (S_ISDIR(st.st_mode))
+		{
+			snprintf(dstpath, sizeof(dstpath), "%s/%s", dst, de->d_name);
+			if (mkdir(dstpath, pg_dir_create_mode) != 0 && errno != EEXIST)
+			{
+				pg_log_error("could not create directory \"%s\": %m", dstpath);
+				exit(1);
+			}
+			apply_incremental_dir(srcpath, dstpath);
+		}
+		else if (!S_ISREG(st.st_mode))
+		{
+			pg_log_error("\"%s\" is not a regular file or directory; tablespaces are not supported",
+						 srcpath);
+			exit(1);
+		}
+		else if (strncmp(de->d_name, INCREMENTAL_PREFIX,
+						 INCREMENTAL_PREFIX_LENGTH) == 0)
+		{
+			snprintf(dstpath, sizeof(dstpath), "%s/%s", dst,
+					 de->d_name + INCREMENTAL_PREFIX_LENGTH);
+			apply_incremental_file(srcpath, dstpath);
+		}
+		else
+		{
+			snprintf(dstpath, sizeof(dstpath), "%s/%s", dst, de->d_name);
+			copy_file(srcpath, dstpath);
+		}
+	}
+	if (errno)
+	{
+		pg_log_error("could not read directory \"%s\": %m", src);
+		exit(1);
+	}
+	closedir(dir);
+
+	/* Anything the newer backup doesn't have was dropped meanwhile. */
+	remove_missing(src, dst);
+}
+
+/*
+ * Write the blocks contained in the incremental file "src" into the relation
+ * segment "dst", and truncate it to the length recorded in the header.
+ */
+static void
+apply_incremental_file(const char *src, const char *dst)
+{
+	IncrementalFileHeader hdr;
+	BlockNumber *blocks;
+	char		page[BLCKSZ];
+	int			srcfd;
+	int			dstfd;
+	int			flags = O_RDWR | PG_BINARY;
+	uint32		i;
+
+	if ((srcfd = open(src, O_RDONLY | PG_BINARY, 0)) < 0)
+	{
+		pg_log_error("could not open file \"%s\": %m", src);
+		exit(1);
+	}
+
+	if (read(srcfd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+		hdr.magic != INCREMENTAL_MAGIC || hdr.nchanged > hdr.nblocks ||
+		hdr.nblocks > RELSEG_SIZE)
+	{
+		pg_log_error("file \"%s\" is not a valid incremental file", src);
+		exit(1);
+	}
+
+	blocks = pg_malloc(Max(hdr.nchanged, 1) * sizeof(BlockNumber));
+	if (read(srcfd, blocks, hdr.nchanged * sizeof(BlockNumber)) !=
+		hdr.nchanged * sizeof(BlockNumber))
+	{
+		pg_log_error("could not read file \"%s\": %m", src);
+		exit(1);
+	}
+
+	/*
+	 * If the segment doesn't exist in the older backup, it was created since,
+	 * and every block of it must have been sent.  This is not the case when
+	 * files are copied without WAL-logging their contents, as CREATE
+	 * DATABASE and ALTER DATABASE SET TABLESPACE do.
+	 */
+	if (access(dst, F_OK) != 0)
+	{
+		if (hdr.nchanged != hdr.nblocks)
+		{
+			pg_log_error("file \"%s\" is missing from the older backup, and \"%s\" does not contain all of its blocks",
+						 dst, src);
+			exit(1);
+		}
+		flags |= O_CREAT;
+	}
+
+	if ((dstfd = open(dst, flags, pg_file_create_mode)) < 0)
+	{
+		pg_log_error("could not open file \"%s\": %m", dst);
+		exit(1);
+	}
+
+	for (i = 0; i < hdr.nchanged; i++)
+	{
+		if (blocks[i] >= hdr.nblocks)
+		{
+			pg_log_error("file \"%s\" is not a valid incremental file", src);
+			exit(1);
+		}
+		if (read(srcfd, page, BLCKSZ) != BLCKSZ)
+		{
+			pg_log_error("could not read block %u of file \"%s\"",
+						 blocks[i], src);
+			exit(1);
+		}
+		if (lseek(dstfd, (off_t) blocks[i] * BLCKSZ, SEEK_SET) < 0)
+		{
+			pg_log_error("could not seek in file \"%s\": %m", dst);
+			exit(1);
+		}
+		errno = 0;
+		if (write(dstfd, page, BLCKSZ) != BLCKSZ)
+		{
+			/* if write didn't set errno, assume problem is no disk space */
+			if (errno == 0)
+				errno = ENOSPC;
+			pg_log_error("could not write file \"%s\": %m", dst);
+			exit(1);
+		}
+	}
+
+	if (ftruncate(dstfd, (off_t) hdr.nblocks * BLCKSZ) != 0)
+	{
+		pg_log_error("could not truncate file \"%s\": %m", dst);
+		exit(1);
+	}
+
+	if (verbose)
+		pg_log_info("applied %u of %u blocks to \"%s\"",
+					hdr.nchanged, hdr.nblocks, dst);
+
+	pg_free(blocks);
+	close(srcfd);
+	if (close(dstfd) != 0)
+	{
+		pg_log_error("could not close file \"%s\": %m", dst);
+		exit(1);
+	}
+}
+
+/*
+ * Remove the entries of "dst" that have no counterpart in "src".
+ */
+static void
+remove_missing(const char *src, const char *dst)
+{
+	DIR		   *dir;
+	struct dirent *de;
+
+	if ((dir = opendir(dst)) == NULL)
+	{
+		pg_log_error("could not open directory \"%s\": %m", dst);
+		exit(1);
+	}
+
+	while (errno = 0, (de = readdir(dir)) != NULL)
+	{
+		char		srcpath[MAXPGPATH];
+		char		incrpath[MAXPGPATH];
+		char		dstpath[MAXPGPATH];
+		struct stat st;
+
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+			continue;
+
+		snprintf(srcpath, sizeof(srcpath), "%s/%s", src, de->d_name);
+		snprintf(incrpath, sizeof(incrpath), "%s/%s%s", src,
+				 INCREMENTAL_PREFIX, de->d_name);
+		if (lstat(srcpath, &st) == 0 || lstat(incrpath, &st) == 0)
+			continue;
+
+		snprintf(dstpath, sizeof(dstpath), "%s/%s", dst, de->d_name);
+		if (lstat(dstpath, &st) == 0 && S_ISDIR(st.st_mode))
+		{
+			if (!rmtree(dstpath, true))
+			{
+				pg_log_error("could not remove directory \"%s\"", dstpath);
+				exit(1);
+			}
+		}
+		else if (unlink(dstpath) != 0)
+		{
+			pg_log_error("could not remove file \"%s\": %m", dstpath);
+			exit(1);
+		}
+	}
+	if (errno)
+	{
+		pg_log_error("could not read directory \"%s\": %m", dst);
+		exit(1);
+	}
+	closedir(dir);
+}
+
+/*
+ * Remove the "INCREMENTAL FROM LSN" line from the backup_label of the
+ * reconstructed backup, so that the server accepts to start from it.
+ */
+static void
+strip_backup_label(const char *dir)
+{
+	char		path[MAXPGPATH];
+	char		tmppath[MAXPGPATH];
+	char		line[MAXPGPATH];
+	FILE	   *in;
+	FILE	   *out;
+
+	snprintf(path, sizeof(path), "%s/backup_label", dir);
+	snprintf(tmppath, sizeof(tmppath), "%s/backup_label.tmp", dir);
+
+	if ((in = fopen(path, "r")) == NULL)
+	{
+		pg_log_error("could not open file \"%s\": %m", path);
+		exit(1);
+	}
+	if ((out = fopen(tmppath, "w")) == NULL)
+	{
+		pg_log_error("could not create file \"%s\": %m", tmppath);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		if (strncmp(line, "INCREMENTAL FROM LSN: ", 22) == 0)
+			continue;
+		if (fputs(line, out) < 0)
+		{
+			pg_log_error("could not write file \"%s\": %m", tmppath);
+			exit(1);
+		}
+	}
+
+	if (ferror(in))
+	{
+		pg_log_error("could not read file \"%s\": %m", path);
+		exit(1);
+	}
+	fclose(in);
+	if (fclose(out) != 0)
+	{
+		pg_log_error("could not write file \"%s\": %m", tmppath);
+		exit(1);
+	}
+
+	if (rename(tmppath, path) != 0)
+	{
+		pg_log_error("could not rename file \"%s\" to \"%s\": %m",
+					 tmppath, path);
+		exit(1);
+	}
+}
+
+/*
+ * Check that the backup in "dir" belongs to the same cluster as the first
+ * one, and return its system identifier.
+ */
+static uint64
+get_system_identifier(const char *dir)
+{
+	ControlFileData *ControlFile;
+	bool		crc_ok;
+	uint64		sysid;
+
+	ControlFile = get_controlfile(dir, &crc_ok);
+	if (!crc_ok)
+	{
+		pg_log_error("pg_control CRC value is incorrect in backup \"%s\"", dir);
+		exit(1);
+	}
+	if (ControlFile->blcksz != BLCKSZ)
+	{
+		pg_log_error("backup \"%s\" has block size %u, but pg_combinebackup was compiled with block size %u",
+					 dir, ControlFile->blcksz, BLCKSZ);
+		exit(1);
+	}
+
+	sysid = ControlFile->system_identifier;
+	pfree(ControlFile);
+
+	return sysid;
+}
+
+int
+main(int argc, char **argv)
+{
+	static struct option long_options[] = {
+		{"output", required_argument, NULL, 'o'},
+		{"no-sync", no_argument, NULL, 'N'},
+		{"verbose", no_argument, NULL, 'v'},
+		{NULL, 0, NULL, 0}
+	};
+
+	char	   *outdir = NULL;
+	int			c;
+	int			option_index;
+	int			i;
+	uint64		sysid;
+	XLogRecPtr	prev_startlsn = InvalidXLogRecPtr;
+	XLogRecPtr	startlsn;
+	XLogRecPtr	incremental_lsn;
+
+	pg_logging_init(argv[0]);
+	set_pglocale_pgservice(argv[0], PG_TEXTDOMAIN("pg_combinebackup"));
+	progname = get_progname(argv[0]);
+
+	if (argc > 1)
+	{
+		if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-?") == 0)
+		{
+			usage();
+			exit(0);
+		}
+		if (strcmp(argv[1], "--version") == 0 || strcmp(argv[1], "-V") == 0)
+		{
+			puts("pg_combinebackup (PostgreSQL) " PG_VERSION);
+			exit(0);
+		}
+	}
+
+	while ((c = getopt_long(argc, argv, "o:Nv", long_options, &option_index)) != -1)
+	{
+		switch (c)
+		{
+			case 'o':
+				outdir = pg_strdup(optarg);
+				break;
+			case 'N':
+				do_sync = false;
+				break;
+			case 'v':
+				verbose = true;
+				break;
+			default:
+				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+				exit(1);
+		}
+	}
+
+	if (outdir == NULL)
+	{
+		pg_log_error("no output directory specified");
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+		exit(1);
+	}
+
+	if (argc - optind < 2)
+	{
+		pg_log_error("at least one full and one incremental backup must be specified");
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+		exit(1);
+	}
+
+	/* Check the chain of backups before touching anything. */
+	sysid = get_system_identifier(argv[optind]);
+	for (i = optind; i < argc; i++)
+	{
+		bool		incremental;
+
+		if (get_system_identifier(argv[i]) != sysid)
+		{
+			pg_log_error("backup \"%s\" is from a different database cluster than backup \"%s\"",
+						 argv[i], argv[optind]);
+			exit(1);
+		}
+
+		incremental = read_backup_label(argv[i], &startlsn, &incremental_lsn);
+		if (i == optind && incremental)
+		{
+			pg_log_error("backup \"%s\" is an incremental backup, but the first backup must be a full backup",
+						 argv[i]);
+			exit(1);
+		}
+		if (i > optind && !incremental)
+		{
+			pg_log_error("backup \"%s\" is not an incremental backup", argv[i]);
+			exit(1);
+		}
+
+		/*
+		 * A block unchanged since incremental_lsn must be taken from the
+		 * previous backup, which is only safe if that one started afterwards.
+		 */
+		if (i > optind && incremental_lsn > prev_startlsn)
+		{
+			pg_log_error("backup \"%s\" is incremental from %X/%X, but the previous backup starts at %X/%X",
+						 argv[i],
+						 (uint32) (incremental_lsn >> 32), (uint32) incremental_lsn,
+						 (uint32) (prev_startlsn >> 32), (uint32) prev_startlsn);
+			exit(1);
+		}
+
+		prev_startlsn = startlsn;
+	}
+
+	if (mkdir(outdir, pg_dir_create_mode) != 0)
+	{
+		pg_log_error("could not create directory \"%s\": %m", outdir);
+		exit(1);
+	}
+
+	if (verbose)
+		pg_log_info("copying full backup \"%s\"", argv[optind]);
+	copy_directory(argv[optind], outdir);
+
+	for (i = optind + 1; i < argc; i++)
+	{
+		if (verbose)
+			pg_log_info("applying incremental backup \"%s\"", argv[i]);
+		apply_incremental_dir(argv[i], outdir);
+	}
+
+	strip_backup_label(outdir);
+
+	if (do_sync)
+		fsync_pgdata(outdir, PG_VERSION_NUM);
+
+	return 0;
+}
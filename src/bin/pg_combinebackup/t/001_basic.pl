@@ -0,0 +1,96 @@
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 22;
+
+program_help_ok('pg_combinebackup');
+program_version_ok('pg_combinebackup');
+program_options_handling_ok('pg_combinebackup');
+
+my $node = get_new_node('main');
+$node->init(allows_streaming => 1);
+$node->start;
+
+$node->safe_psql('postgres', q{
+	CREATE TABLE changed AS SELECT g AS a FROM generate_series(1, 10000) g;
+	CREATE TABLE unchanged AS SELECT g AS a FROM generate_series(1, 10000) g;
+	CREATE TABLE dropped (a int);
+	CREATE SEQUENCE seq;
+	SELECT nextval('seq');
+	CHECKPOINT;
+});
+
+my $backupdir = $node->backup_dir;
+$node->command_ok(
+	[ 'pg_basebackup', '-D', "$backupdir/full", '-X', 'stream', '--no-sync' ],
+	'full backup');
+
+$node->safe_psql('postgres', q{
+	UPDATE changed SET a = -a WHERE a % 1000 = 0;
+	CREATE TABLE created AS SELECT g AS a FROM generate_series(1, 100) g;
+	DROP TABLE dropped;
+	SELECT nextval('seq');
+	CHECKPOINT;
+});
+
+$node->command_ok(
+	[
+		'pg_basebackup', '-D', "$backupdir/incr1", '-X', 'stream',
+		'--no-sync', '--incremental', "$backupdir/full"
+	],
+	'incremental backup');
+
+$node->safe_psql('postgres', q{
+	TRUNCATE created;
+	INSERT INTO created VALUES (42);
+	SELECT nextval('seq');
+	CHECKPOINT;
+});
+
+$node->command_ok(
+	[
+		'pg_basebackup', '-D', "$backupdir/incr2", '-X', 'stream',
+		'--no-sync', '--incremental', "$backupdir/incr1"
+	],
+	'incremental backup on top of incremental backup');
+
+my $unchanged = $node->safe_psql('postgres',
+	q{SELECT pg_relation_filepath('unchanged')});
+my ($unchanged_dir, $unchanged_file) = $unchanged =~ m{^(.*)/([^/]+)$};
+ok(-f "$backupdir/incr1/$unchanged_dir/INCREMENTAL.$unchanged_file",
+	'relation is sent incrementally');
+ok(!-f "$backupdir/incr1/$unchanged",
+	'relation is not sent in full');
+
+command_fails(
+	[ 'pg_combinebackup', '-o', "$backupdir/bad", "$backupdir/incr1",
+	  "$backupdir/incr2" ],
+	'first backup must be a full backup');
+command_fails(
+	[ 'pg_combinebackup', '-o', "$backupdir/bad", "$backupdir/full",
+	  "$backupdir/incr2" ],
+	'gaps in the chain of backups are rejected');
+
+command_ok(
+	[ 'pg_combinebackup', '-o', "$backupdir/combined", "$backupdir/full",
+	  "$backupdir/incr1", "$backupdir/incr2" ],
+	'combine backups');
+ok(-f "$backupdir/combined/$unchanged", 'relation is reconstructed');
+
+my $restored = get_new_node('restored');
+$restored->init_from_backup($node, 'combined');
+$restored->start;
+
+is($restored->safe_psql('postgres', 'SELECT sum(a) FROM changed'),
+	$node->safe_psql('postgres', 'SELECT sum(a) FROM changed'),
+	'changed relation is restored');
+is($restored->safe_psql('postgres', 'SELECT sum(a) FROM unchanged'),
+	'50005000', 'unchanged relation is restored');
+is($restored->safe_psql('postgres', 'SELECT * FROM created'),
+	'42', 'created and truncated relation is restored');
+is($restored->safe_psql('postgres',
+		q{SELECT count(*) FROM pg_class WHERE relname = 'dropped'}),
+	'0', 'dropped relation is gone');
+cmp_ok($restored->safe_psql('postgres', q{SELECT nextval('seq')}),
+	'>', 3, 'sequence is restored');
@@ -208,6 +208,21 @@
 #define unlikely(x) ((x) != 0)
 #endif
 
+/*
+ * pg_prefetch_mem
+ *		Hint to the CPU that the memory at the given address will be read
+ *		soon, so that it can start bringing it into cache.
+ *
+ * This is only a hint and never faults, so it's OK to pass an address that
+ * is NULL or otherwise invalid.  As with likely(), use it only in hot loops
+ * where it has been shown to help.
+ */
+#if __GNUC__ >= 3
+#define pg_prefetch_mem(a) __builtin_prefetch(a)
+#else
+#define pg_prefetch_mem(a) ((void) 0)
+#endif
+
 /*
  * CppAsString
  *		Convert the argument to a string, using the C preprocessor.
@@ -143,6 +143,8 @@ extern TupleHashEntry FindTupleHashEntry(TupleHashTable hashtable,
 										 TupleTableSlot *slot,
 										 ExprState *eqcomp,
 										 FmgrInfo *hashfunctions);
+extern uint32 TupleHashTableHashSlot(TupleHashTable hashtable,
+									 TupleTableSlot *slot);
 extern void ResetTupleHashTable(TupleHashTable hashtable);
 
 /*
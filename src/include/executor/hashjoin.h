@@ -14,6 +14,7 @@
 #ifndef HASHJOIN_H
 #define HASHJOIN_H
 
+#include "lib/bloomfilter.h"
 #include "nodes/execnodes.h"
 #include "port/atomics.h"
 #include "storage/barrier.h"
@@ -110,6 +111,15 @@ typedef struct HashSkewBucket
 #define SKEW_WORK_MEM_PERCENT  2
 #define SKEW_MIN_OUTER_FRACTION  0.01
 
+/*
+ * The bloom filter of a multi-batch join (see HashJoinTableData) is limited
+ * to BLOOM_WORK_MEM_PERCENT of the memory allowed for the join, and counts
+ * against it.  Since bloom_create() never makes a filter smaller than 1MB,
+ * joins allowed less than 100 / BLOOM_WORK_MEM_PERCENT times that don't get
+ * a filter.
+ */
+#define BLOOM_WORK_MEM_PERCENT	25
+
 /*
  * To reduce palloc overhead, the HashJoinTuples for the current batch are
  * packed in 32kB buffers instead of pallocing each tuple individually.
@@ -329,6 +339,16 @@ typedef struct HashJoinTableData
 	BufFile   **innerBatchFile; /* buffered virtual temp file per batch */
 	BufFile   **outerBatchFile; /* buffered virtual temp file per batch */
 
+	/*
+	 * Bloom filter over the hash values of all inner tuples, built only for
+	 * parallel-oblivious joins that go multi-batch and don't need to emit
+	 * unmatched outer tuples.  The hash join uses it to discard outer tuples
+	 * that cannot match instead of writing them to an outer batch file.
+	 */
+	bool		useBloomFilter; /* may we build bloomFilter? */
+	double		innerRows;		/* planner's estimate of inner tuples */
+	bloom_filter *bloomFilter;	/* NULL if not (yet) built */
+
 	/*
 	 * Info about the datatype-specific hash functions for the datatypes being
 	 * hashed. These are arrays of the same length as the number of hash join
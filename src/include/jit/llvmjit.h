@@ -55,6 +55,9 @@ typedef struct LLVMJitContext
 
 	/* list of handles for code emitted via Orc */
 	List	   *handles;
+
+	/* deform functions already generated in the current module */
+	List	   *deform_functions;
 } LLVMJitContext;
 
 
@@ -119,6 +122,7 @@ extern bool llvm_compile_expr(struct ExprState *state);
 struct TupleTableSlotOps;
 extern LLVMValueRef slot_compile_deform(struct LLVMJitContext *context, TupleDesc desc,
 										const struct TupleTableSlotOps *ops, int natts);
+extern void llvm_forget_deform_functions(struct LLVMJitContext *context);
 
 /*
  ****************************************************************************
@@ -16,6 +16,7 @@
 
 #include "access/tupconvert.h"
 #include "executor/instrument.h"
+#include "lib/ilist.h"
 #include "lib/pairingheap.h"
 #include "nodes/params.h"
 #include "nodes/plannodes.h"
@@ -1198,6 +1199,12 @@ typedef struct ModifyTableState
 
 	/* Per plan map for tuple conversion from child to root */
 	TupleConversionMap **mt_per_subplan_tupconv_maps;
+
+	/* Batching of plain inserts, see ExecInitModifyTable */
+	bool		mt_batch_insert;	/* are inserts buffered? */
+	TupleTableSlot **mt_batch_slots;	/* buffered tuples */
+	int			mt_batch_nused;	/* number of buffered tuples */
+	Size		mt_batch_bytes; /* approximate size of buffered tuples */
 } ModifyTableState;
 
 /* ----------------
@@ -1989,6 +1996,48 @@ typedef struct MaterialState
 	Tuplestorestate *tuplestorestate;
 } MaterialState;
 
+/* ----------------
+ *	 ResultCacheState information
+ *
+ *		result cache nodes remember the output of their parameterized
+ *		subplan for recently seen parameter values, up to work_mem, and
+ *		return it from memory when the same values come back.
+ * ----------------
+ */
+struct ResultCacheEntry;
+struct ResultCacheTuple;
+struct resultcache_hash;
+
+typedef struct ResultCacheState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	int			rc_status;		/* state of the ExecResultCache state machine */
+	int			nkeys;			/* number of cache keys */
+	struct resultcache_hash *hashtable; /* hash table of cache entries */
+	TupleDesc	hashkeydesc;	/* tuple descriptor of cache keys */
+	TupleTableSlot *tableslot;	/* slot holding the key of a cache entry */
+	TupleTableSlot *probeslot;	/* slot holding the key being looked up */
+	ExprState  *cache_eq_expr;	/* compares tableslot to probeslot */
+	ExprState **param_exprs;	/* exprs computing the current key */
+	FmgrInfo   *hashfunctions;	/* hash function for each key */
+	Oid		   *collations;		/* collation for each key */
+	Bitmapset  *keyparamids;	/* ids of the Params used in param_exprs */
+	uint64		mem_used;		/* bytes of memory used by cache entries */
+	uint64		mem_limit;		/* memory limit for the cache, in bytes */
+	MemoryContext tableContext; /* memory context holding all cache data */
+	dlist_head	lru_list;		/* keys of cache entries, least recently
+								 * used first */
+	struct ResultCacheTuple *last_tuple;	/* last tuple returned or stored */
+	struct ResultCacheEntry *entry; /* the entry last_tuple belongs to */
+	bool		singlerow;		/* mark entries complete after one tuple? */
+	/* instrumentation, for EXPLAIN ANALYZE: */
+	uint64		cache_hits;		/* rescans answered from the cache */
+	uint64		cache_misses;	/* rescans that had to run the subplan */
+	uint64		cache_evictions;	/* entries removed to free memory */
+	uint64		cache_overflows;	/* scans too large to cache at all */
+	uint64		mem_peak;		/* peak memory used, in bytes */
+} ResultCacheState;
+
 /* ----------------
  *	 Shared memory container for per-worker sort information
  * ----------------
@@ -2017,6 +2066,32 @@ typedef struct SortState
 	SharedSortInfo *shared_info;	/* one entry per worker */
 } SortState;
 
+/* ----------------
+ *	 IncrementalSortState information
+ *
+ *	 Input tuples are collected in batches of at least a few tuples that end
+ *	 at a change of the presorted key columns, and each batch is sorted on
+ *	 its own.
+ * ----------------
+ */
+typedef struct IncrementalSortState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	bool		bounded;		/* is the result set bounded? */
+	int64		bound;			/* if bounded, how many tuples are needed */
+	int64		bound_Done;		/* tuples of the bound sorted so far */
+	bool		batch_sorted;	/* current batch sorted, being returned? */
+	bool		outer_done;		/* all input tuples read? */
+	ExprState  *presorted_eq;	/* equality of presorted key columns */
+	TupleTableSlot *group_pivot;	/* tuple whose group ends the batch */
+	TupleTableSlot *transfer_tuple; /* first tuple of the next batch */
+	void	   *tuplesortstate; /* private state of tuplesort.c */
+	/* instrumentation, for EXPLAIN ANALYZE: */
+	int64		nbatches;		/* number of batches sorted */
+	long		max_memory_used;	/* peak kB of memory used by a batch */
+	long		max_disk_used;	/* peak kB of disk used by a batch */
+} IncrementalSortState;
+
 /* ---------------------
  *	GroupState information
  * ---------------------
@@ -2097,6 +2172,23 @@ typedef struct AggState
 	AggStatePerGroup *all_pergroups;	/* array of first ->pergroups, than
 										 * ->hash_pergroup */
 	ProjectionInfo *combinedproj;	/* projection machinery */
+	/* these fields are used when AGG_HASHED spills groups to disk: */
+	bool		hash_spill_allowed; /* can the hash table spill at all? */
+	bool		hash_spill_mode;	/* table is full, spill tuples of new
+									 * groups */
+	Size		hash_mem_limit; /* spill once the table uses more than this */
+	Size		hash_mem_peak;	/* peak memory used by the hash table */
+	uint64		hash_ngroups_current;	/* number of groups in the table */
+	uint64		hash_next_check;	/* recheck memory usage at this many
+									 * groups */
+	int			hash_used_bits; /* hash bits that partitioned current input */
+	struct HashAggSpill *hash_spill;	/* spill files of the current pass */
+	List	   *hash_batches;	/* spilled partitions yet to be processed */
+	TupleTableSlot *hash_spill_slot;	/* slot for reading spilled tuples */
+	char	   *hash_spill_buf; /* buffer for reading spilled tuples */
+	Size		hash_spill_buflen;	/* allocated size of hash_spill_buf */
+	uint64		hash_disk_used; /* kB of disk space written by spilling */
+	int			hash_batches_used;	/* number of spilled batches processed */
 } AggState;
 
 /* ----------------
@@ -1423,6 +1423,22 @@ typedef struct MaterialPath
 	Path	   *subpath;
 } MaterialPath;
 
+/*
+ * ResultCachePath represents a ResultCache plan node, i.e., a cache of the
+ * output of a parameterized subpath for each set of parameter values, so that
+ * repeated scans with the same values don't have to run the subpath again.
+ */
+typedef struct ResultCachePath
+{
+	Path		path;
+	Path	   *subpath;		/* parameterized path whose output is cached */
+	List	   *hash_operators; /* hash equality operators for each key */
+	List	   *param_exprs;	/* outer exprs the cache is keyed on */
+	bool		singlerow;		/* does each scan return at most one row? */
+	double		calls;			/* expected number of rescans */
+	uint32		est_entries;	/* expected number of cache entries, or 0 */
+} ResultCachePath;
+
 /*
  * UniquePath represents elimination of distinct rows from the output of
  * its subpath.
@@ -1615,6 +1631,16 @@ typedef struct SortPath
 	Path	   *subpath;		/* path representing input source */
 } SortPath;
 
+/*
+ * IncrementalSortPath represents a sort step that relies on its input being
+ * sorted by a prefix of the sort keys already
+ */
+typedef struct IncrementalSortPath
+{
+	SortPath	spath;
+	int			nPresortedCols; /* number of presorted columns */
+} IncrementalSortPath;
+
 /*
  * GroupPath represents grouping (of presorted input)
  *
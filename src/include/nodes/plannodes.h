@@ -756,6 +756,25 @@ typedef struct Material
 	Plan		plan;
 } Material;
 
+/* ----------------
+ *		result cache node
+ *
+ * Caches the output of its parameterized subplan, keyed by the values of
+ * param_exprs, so that rescans with parameter values seen before need not
+ * execute the subplan again.
+ * ----------------
+ */
+typedef struct ResultCache
+{
+	Plan		plan;
+	int			numKeys;		/* size of the two arrays below */
+	Oid		   *hashOperators;	/* hash equality operators for each key */
+	Oid		   *collations;		/* collations for each key */
+	List	   *param_exprs;	/* exprs containing the cache key values */
+	bool		singlerow;		/* does each scan return at most one row? */
+	uint32		est_entries;	/* expected number of cache entries, or 0 */
+} ResultCache;
+
 /* ----------------
  *		sort node
  * ----------------
@@ -770,6 +789,19 @@ typedef struct Sort
 	bool	   *nullsFirst;		/* NULLS FIRST/LAST directions */
 } Sort;
 
+/* ----------------
+ *		incremental sort node
+ *
+ * The input is already sorted by the first nPresortedCols sort keys, so only
+ * groups of tuples that agree on those need to be sorted.
+ * ----------------
+ */
+typedef struct IncrementalSort
+{
+	Sort		sort;
+	int			nPresortedCols; /* number of presorted columns */
+} IncrementalSort;
+
 /* ---------------
  *	 group node -
  *		Used for queries with GROUP BY (but no aggregates) specified.
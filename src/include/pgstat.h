@@ -1096,6 +1096,13 @@ typedef struct PgBackendStatus
 	ProgressCommandType st_progress_command;
 	Oid			st_progress_command_target;
 	int64		st_progress_param[PGSTAT_NUM_PROGRESS_PARAM];
+
+	/*
+	 * Memory currently allocated by the process's memory contexts.  This is
+	 * updated far too often to follow the st_changecount protocol, so it is
+	 * written and read atomically instead; see pgstat_report_mem_allocated().
+	 */
+	pg_atomic_uint64 st_mem_allocated;
 } PgBackendStatus;
 
 /*
@@ -1185,6 +1192,12 @@ typedef struct LocalPgBackendStatus
 	 * not.
 	 */
 	TransactionId backend_xmin;
+
+	/*
+	 * Bytes allocated by the backend's memory contexts, read atomically from
+	 * st_mem_allocated.
+	 */
+	uint64		backend_mem_allocated;
 } LocalPgBackendStatus;
 
 /*
@@ -1216,6 +1229,12 @@ extern char *pgstat_stat_directory;
 extern char *pgstat_stat_tmpname;
 extern char *pgstat_stat_filename;
 
+/*
+ * Points to st_mem_allocated in this backend's PgBackendStatus entry, or is
+ * NULL while we don't have one.
+ */
+extern PGDLLIMPORT pg_atomic_uint64 *my_mem_allocated;
+
 /*
  * BgWriter statistics counters are updated directly by bgwriter and bufmgr
  */
@@ -1353,6 +1372,22 @@ pgstat_report_wait_end(void)
 	proc->wait_event_info = 0;
 }
 
+/* ----------
+ * pgstat_report_mem_allocated() -
+ *
+ *	Called by the memory context machinery whenever the total memory
+ *	allocated by this process changes.  There's a single writer, so no
+ *	locking is needed; the atomic write only makes sure readers never see a
+ *	torn value.
+ * ----------
+ */
+static inline void
+pgstat_report_mem_allocated(uint64 allocated)
+{
+	if (my_mem_allocated)
+		pg_atomic_write_u64(my_mem_allocated, allocated);
+}
+
 /* nontransactional event counts are simple enough to inline */
 
 #define pgstat_count_heap_scan(rel)									\
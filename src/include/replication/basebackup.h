@@ -20,6 +20,24 @@
 #define MAX_RATE_LOWER	32
 #define MAX_RATE_UPPER	1048576
 
+/*
+ * In an incremental backup, relation segments are sent as files named
+ * INCREMENTAL_PREFIX followed by the segment's file name.  Such a file starts
+ * with an IncrementalFileHeader, followed by the numbers of the blocks it
+ * contains, followed by the contents of those blocks.  All other blocks are
+ * unchanged since the reference backup.
+ */
+#define INCREMENTAL_PREFIX			"INCREMENTAL."
+#define INCREMENTAL_PREFIX_LENGTH	(sizeof(INCREMENTAL_PREFIX) - 1)
+#define INCREMENTAL_MAGIC			0x494E4352
+
+typedef struct IncrementalFileHeader
+{
+	uint32		magic;			/* INCREMENTAL_MAGIC */
+	uint32		nblocks;		/* length of the segment, in blocks */
+	uint32		nchanged;		/* number of blocks contained in the file */
+} IncrementalFileHeader;
+
 
 typedef struct
 {
@@ -61,6 +61,10 @@ typedef struct catcache
 	slist_node	cc_next;		/* list link */
 	ScanKeyData cc_skey[CATCACHE_MAXKEYS];	/* precomputed key info for heap
 											 * scans */
+	Size		cc_nbytes;		/* memory used by this cache's tuples */
+	int64		cc_nhits;		/* # of searches satisfied by the cache */
+	int64		cc_nmisses;		/* # of searches that read the catalog */
+	int64		cc_nevictions;	/* # of entries evicted to save memory */
 
 	/*
 	 * Keep these at the end, so that compiling catcache.c with CATCACHE_STATS
@@ -103,6 +107,15 @@ typedef struct catctup
 	 */
 	dlist_node	cache_elem;		/* list member of per-bucket list */
 
+	/*
+	 * Each tuple is also a member of the global list scanned by the clock
+	 * sweep that enforces catalog_cache_memory_limit.  recently_used is set
+	 * whenever a search finds the entry, and cleared by the sweep, which
+	 * evicts unreferenced entries it finds without the flag.
+	 */
+	dlist_node	lru_elem;		/* list member of global eviction list */
+	bool		recently_used;	/* found by a search since last sweep? */
+
 	/*
 	 * A tuple marked "dead" must not be returned by subsequent searches.
 	 * However, it won't be physically deleted from the cache until its
@@ -183,9 +196,15 @@ typedef struct catcacheheader
 {
 	slist_head	ch_caches;		/* head of list of CatCache structs */
 	int			ch_ntup;		/* # of tuples in all caches */
+	Size		ch_nbytes;		/* memory used by tuples in all caches */
+	dlist_head	ch_lru;			/* all tuples, in clock sweep order */
 } CatCacheHeader;
 
 
+/* GUC variable */
+extern int	catalog_cache_memory_limit;
+
+
 /* this extern duplicates utils/memutils.h... */
 extern PGDLLIMPORT MemoryContext CacheMemoryContext;
 
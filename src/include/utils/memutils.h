@@ -83,7 +83,8 @@ extern Size GetMemoryChunkSpace(void *pointer);
 extern MemoryContext MemoryContextGetParent(MemoryContext context);
 extern bool MemoryContextIsEmpty(MemoryContext context);
 extern void MemoryContextStats(MemoryContext context);
-extern void MemoryContextStatsDetail(MemoryContext context, int max_children);
+extern void MemoryContextStatsDetail(MemoryContext context, int max_children,
+									 bool print_to_stderr);
 extern void MemoryContextAllowInCriticalSection(MemoryContext context,
 												bool allow);
 
@@ -91,6 +92,20 @@ extern void MemoryContextAllowInCriticalSection(MemoryContext context,
 extern void MemoryContextCheck(MemoryContext context);
 #endif
 extern bool MemoryContextContains(MemoryContext context, void *pointer);
+extern Size MemoryContextMemAllocated(MemoryContext context, bool recurse);
+
+/*
+ * Memory accounting.  Context types call these whenever they malloc() or
+ * free() a block, so that each context's mem_allocated and the backend-wide
+ * total (published in shared memory by pgstat.c) stay current.
+ */
+extern PGDLLIMPORT Size BackendMemoryAllocated;
+
+extern void MemoryContextAccountAlloc(MemoryContext context, Size size);
+extern void MemoryContextAccountFree(MemoryContext context, Size size);
+
+extern void HandleLogMemoryContextInterrupt(void);
+extern void ProcessLogMemoryContextInterrupt(void);
 
 /* Handy macro for copying and assigning context ID ... but note double eval */
 #define MemoryContextCopyAndSetIdentifier(cxt, id) \
@@ -179,7 +194,15 @@ extern MemoryContext SlabContextCreate(MemoryContext parent,
 /* generation.c */
 extern MemoryContext GenerationContextCreate(MemoryContext parent,
 											 const char *name,
-											 Size blockSize);
+											 Size initBlockSize,
+											 Size maxBlockSize);
+
+/* bump.c */
+extern MemoryContext BumpContextCreate(MemoryContext parent,
+									   const char *name,
+									   Size minContextSize,
+									   Size initBlockSize,
+									   Size maxBlockSize);
 
 /*
  * Recommended default alloc parameters, suitable for "ordinary" contexts
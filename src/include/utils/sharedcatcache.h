@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedcatcache.h
+ *	  Catalog cache tuples shared by all backends.
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/utils/sharedcatcache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SHAREDCATCACHE_H
+#define SHAREDCATCACHE_H
+
+#include "storage/sinval.h"
+#include "utils/catcache.h"
+
+/* GUC variable */
+extern int	shared_catcache_size;
+
+extern Size SharedCatCacheShmemSize(void);
+extern void SharedCatCacheShmemInit(void);
+extern void SharedCatCacheAttach(void);
+
+extern bool SharedCatCacheEnabled(void);
+extern HeapTuple SharedCatCacheLookup(CatCache *cache, uint32 hashValue,
+									  Datum *arguments, uint64 *generation);
+extern void SharedCatCacheInsert(CatCache *cache, uint32 hashValue,
+								 HeapTuple tuple, uint64 generation);
+
+extern void SharedCatCacheInvalidate(const SharedInvalidationMessage *msgs,
+									 int n);
+extern void SharedCatCacheInvalidateDatabase(Oid dbId);
+
+#endif							/* SHAREDCATCACHE_H */
@@ -143,6 +143,7 @@ extern char *ExportSnapshot(Snapshot snapshot);
  * Utility functions for implementing visibility routines in table AMs.
  */
 extern bool XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot);
+extern void SnapshotSortXids(Snapshot snapshot);
 
 /* Support for catalog timetravel for logical decoding */
 struct HTAB;
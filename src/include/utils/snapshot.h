@@ -164,6 +164,9 @@ typedef struct SnapshotData
 	 * it contains *committed* transactions between xmin and xmax.
 	 *
 	 * note: all ids in xip[] satisfy xmin <= xip[i] < xmax
+	 *
+	 * In normal MVCC snapshots a long xip[] is sorted in xid order (see
+	 * SnapshotSortXids), so that XidInMVCCSnapshot can binary-search it.
 	 */
 	TransactionId *xip;
 	uint32		xcnt;			/* # of xact ids in xip[] */
@@ -176,6 +179,9 @@ typedef struct SnapshotData
 	 *
 	 * note: all ids in subxip[] are >= xmin, but we don't bother filtering
 	 * out any that are >= xmax
+	 *
+	 * Like xip[], subxip[] is sorted in normal MVCC snapshots, unless it is
+	 * not used at all because suboverflowed is set outside recovery.
 	 */
 	TransactionId *subxip;
 	int32		subxcnt;		/* # of xact ids in subxip[] */
@@ -201,6 +207,14 @@ typedef struct SnapshotData
 
 	TimestampTz whenTaken;		/* timestamp when snapshot was taken */
 	XLogRecPtr	lsn;			/* position in the WAL stream when taken */
+
+	/*
+	 * The transaction completion count at the time GetSnapshotData() built
+	 * this snapshot. Allows to avoid re-computing static snapshots when no
+	 * transactions completed since the last GetSnapshotData().  Zero if the
+	 * contents weren't built by GetSnapshotData().
+	 */
+	uint64		snapXactCompletionCount;
 } SnapshotData;
 
 #endif							/* SNAPSHOT_H */
@@ -0,0 +1,28 @@
+# Snapshots taken after PREPARE TRANSACTION
+#
+# A backend's snapshots leave out its own xid.  Once the transaction has
+# been prepared, the next snapshot taken in the same session must see the
+# prepared xid as running, and not reuse the previous snapshot.  Otherwise
+# the prepared transaction's rows would be taken for aborted ones, and
+# hinted as such, so they would stay invisible after COMMIT PREPARED.
+
+setup
+{
+  CREATE TABLE snap_prepared (a int);
+}
+
+teardown
+{
+  DROP TABLE snap_prepared;
+}
+
+session "s1"
+step "w1"	{ BEGIN; INSERT INTO snap_prepared VALUES (1); }
+step "r1"	{ SELECT count(*) FROM snap_prepared; }
+step "p1"	{ PREPARE TRANSACTION 'snap_prepared'; }
+step "c1"	{ COMMIT PREPARED 'snap_prepared'; }
+
+session "s2"
+step "r2"	{ SELECT count(*) FROM snap_prepared; }
+
+permutation "w1" "r1" "p1" "r1" "r2" "c1" "r1" "r2"
@@ -0,0 +1,57 @@
+# Visibility with many subtransactions
+#
+# Snapshots search xip[] and subxip[] with a binary search once they have
+# more than 16 entries.  Open a transaction with 20 subtransactions, one of
+# them aborted, and commit another transaction whose xid falls between
+# them, then check what a concurrent snapshot can see.
+
+setup
+{
+  CREATE TABLE snap_subxids (a int);
+}
+
+teardown
+{
+  DROP TABLE snap_subxids;
+}
+
+session "s1"
+step "b1"	{ BEGIN; }
+step "sub1a"
+{
+  DO $$
+  BEGIN
+    FOR i IN 1..10 LOOP
+      BEGIN
+        INSERT INTO snap_subxids VALUES (i);
+      EXCEPTION WHEN division_by_zero THEN NULL;
+      END;
+    END LOOP;
+  END $$;
+}
+step "sub1b"
+{
+  DO $$
+  BEGIN
+    FOR i IN 11..20 LOOP
+      BEGIN
+        INSERT INTO snap_subxids VALUES (i);
+        IF i = 15 THEN
+          RAISE division_by_zero;
+        END IF;
+      EXCEPTION WHEN division_by_zero THEN NULL;
+      END;
+    END LOOP;
+  END $$;
+}
+step "r1"	{ SELECT count(*) FROM snap_subxids; }
+step "c1"	{ COMMIT; }
+
+session "s2"
+step "w2"	{ INSERT INTO snap_subxids VALUES (100); }
+
+session "s3"
+step "r3"	{ SELECT count(*) FROM snap_subxids; }
+step "r3x"	{ SELECT count(*) FROM snap_subxids WHERE a = 100; }
+
+permutation "b1" "sub1a" "w2" "sub1b" "r1" "r3" "r3x" "c1" "r3"
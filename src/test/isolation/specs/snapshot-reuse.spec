@@ -0,0 +1,29 @@
+# Snapshot reuse
+#
+# GetSnapshotData() reuses the previous snapshot if no transaction has
+# completed since it was taken.  Check that a read committed transaction
+# still sees the changes committed by others between its statements, while
+# a repeatable read transaction keeps its snapshot.
+
+setup
+{
+  CREATE TABLE snap_reuse (a int);
+}
+
+teardown
+{
+  DROP TABLE snap_reuse;
+}
+
+session "s1"
+step "b1rc"	{ BEGIN ISOLATION LEVEL READ COMMITTED; }
+step "b1rr"	{ BEGIN ISOLATION LEVEL REPEATABLE READ; }
+step "r1"	{ SELECT count(*) FROM snap_reuse; }
+step "c1"	{ COMMIT; }
+
+session "s2"
+step "w2"	{ INSERT INTO snap_reuse VALUES (1); }
+step "d2"	{ DELETE FROM snap_reuse; }
+
+permutation "b1rc" "r1" "w2" "r1" "d2" "r1" "c1"
+permutation "b1rr" "r1" "w2" "r1" "d2" "r1" "c1"
@@ -0,0 +1,28 @@
+CREATE EXTENSION test_bump;
+
+--
+-- All the logic is in the test_bump() function. It will throw
+-- an error if something fails.
+--
+SELECT test_bump();
+
+--
+-- Check that the benchmark functions work, and that narrow tuples take up
+-- less memory in a bump context than in an aset.c one.  Timings vary too
+-- much to show here.
+--
+SELECT b.used_bytes < a.used_bytes AS bump_is_smaller
+FROM bench_store_tuples('aset', 100000, 24, 1) a,
+     bench_store_tuples('bump', 100000, 24, 1) b;
+
+SELECT b.used_bytes < g.used_bytes AS bump_is_smaller
+FROM bench_store_tuples('generation', 100000, 24, 1) g,
+     bench_store_tuples('bump', 100000, 24, 1) b;
+
+SELECT b.used_bytes < a.used_bytes AS bump_is_smaller
+FROM bench_copy_plan('aset', 'SELECT relname, count(*) FROM pg_class c JOIN pg_attribute a ON a.attrelid = c.oid GROUP BY relname ORDER BY 2', 1) a,
+     bench_copy_plan('bump', 'SELECT relname, count(*) FROM pg_class c JOIN pg_attribute a ON a.attrelid = c.oid GROUP BY relname ORDER BY 2', 1) b;
+
+-- error cases
+SELECT bench_store_tuples('slab', 10, 10);
+SELECT bench_store_tuples('bump', -1, 10);
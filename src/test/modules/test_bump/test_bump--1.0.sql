@@ -0,0 +1,27 @@
+/* src/test/modules/test_bump/test_bump--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_bump" to load this file. \quit
+
+CREATE FUNCTION test_bump()
+RETURNS pg_catalog.void STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_copy_plan(context_type text,
+    query text,
+    nloops integer DEFAULT 1000,
+    OUT elapsed_ms float8,
+    OUT total_bytes int8,
+    OUT used_bytes int8)
+RETURNS record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_store_tuples(context_type text,
+    ntuples integer,
+    tuple_width integer,
+    nloops integer DEFAULT 10,
+    OUT elapsed_ms float8,
+    OUT total_bytes int8,
+    OUT used_bytes int8)
+RETURNS record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
@@ -0,0 +1,292 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_bump.c
+ *		Test and benchmark the bump memory context.
+ *
+ * Copyright (c) 2019, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_bump/test_bump.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "nodes/memnodes.h"
+#include "portability/instr_time.h"
+#include "tcop/tcopprot.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(test_bump);
+PG_FUNCTION_INFO_V1(bench_copy_plan);
+PG_FUNCTION_INFO_V1(bench_store_tuples);
+
+static void test_chunks(const char *test_name, int nchunks, Size minsize,
+						Size maxsize);
+static MemoryContext create_bench_context(const char *context_type,
+										  Size maxBlockSize);
+static Datum make_bench_result(FunctionCallInfo fcinfo,
+							   instr_time elapsed,
+							   MemoryContextCounters *counters);
+
+/*
+ * SQL-callable entry point to perform all tests.
+ */
+Datum
+test_bump(PG_FUNCTION_ARGS)
+{
+	test_chunks("small chunks", 100000, 1, 64);
+	test_chunks("mixed chunk sizes", 10000, 1, 8192);
+	test_chunks("large chunks", 50, 100000, 1000000);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Allocate 'nchunks' chunks with sizes between 'minsize' and 'maxsize' in a
+ * bump context, fill each with a different byte, and check that none of them
+ * overwrote another.  Do that a few times, resetting the context in between.
+ */
+static void
+test_chunks(const char *test_name, int nchunks, Size minsize, Size maxsize)
+{
+	MemoryContext bump_ctx;
+	char	  **chunks;
+	Size	   *sizes;
+	int			round;
+	int			i;
+	Size		j;
+
+	elog(NOTICE, "testing bump context with %s", test_name);
+
+	bump_ctx = BumpContextCreate(CurrentMemoryContext,
+								 "test_bump",
+								 ALLOCSET_DEFAULT_SIZES);
+	chunks = palloc(nchunks * sizeof(char *));
+	sizes = palloc(nchunks * sizeof(Size));
+
+	for (round = 0; round < 3; round++)
+	{
+		if (!MemoryContextIsEmpty(bump_ctx))
+			elog(ERROR, "bump context is not empty after reset");
+
+		for (i = 0; i < nchunks; i++)
+		{
+			/* vary the sizes deterministically */
+			sizes[i] = minsize + ((Size) i * 7919 + round) % (maxsize - minsize + 1);
+			chunks[i] = MemoryContextAlloc(bump_ctx, sizes[i]);
+
+			if (chunks[i] != (char *) MAXALIGN(chunks[i]))
+				elog(ERROR, "chunk %d is not maxaligned", i);
+
+			memset(chunks[i], i & 0xFF, sizes[i]);
+		}
+
+		for (i = 0; i < nchunks; i++)
+		{
+			for (j = 0; j < sizes[i]; j++)
+			{
+				if ((unsigned char) chunks[i][j] != (i & 0xFF))
+					elog(ERROR, "chunk %d of size %zu was overwritten at offset %zu",
+						 i, sizes[i], j);
+			}
+		}
+
+		if (MemoryContextIsEmpty(bump_ctx))
+			elog(ERROR, "bump context is empty after allocations");
+
+		MemoryContextReset(bump_ctx);
+	}
+
+	MemoryContextDelete(bump_ctx);
+	pfree(chunks);
+	pfree(sizes);
+}
+
+/*
+ * Create a memory context of the type named by 'context_type'.  Generation
+ * contexts start with ALLOCSET_DEFAULT_INITSIZE blocks, growing up to
+ * 'maxBlockSize'.
+ */
+static MemoryContext
+create_bench_context(const char *context_type, Size maxBlockSize)
+{
+	if (strcmp(context_type, "aset") == 0)
+		return AllocSetContextCreate(CurrentMemoryContext,
+									 "bench",
+									 ALLOCSET_DEFAULT_SIZES);
+	else if (strcmp(context_type, "generation") == 0)
+		return GenerationContextCreate(CurrentMemoryContext,
+									   "bench",
+									   ALLOCSET_DEFAULT_INITSIZE,
+									   maxBlockSize);
+	else if (strcmp(context_type, "bump") == 0)
+		return BumpContextCreate(CurrentMemoryContext,
+								 "bench",
+								 ALLOCSET_DEFAULT_SIZES);
+
+	ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			 errmsg("unrecognized context type \"%s\"", context_type),
+			 errhint("Valid context types are \"aset\", \"generation\" and \"bump\".")));
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * Build the (elapsed_ms, total_bytes, used_bytes) result record.
+ */
+static Datum
+make_bench_result(FunctionCallInfo fcinfo, instr_time elapsed,
+				  MemoryContextCounters *counters)
+{
+	TupleDesc	tupdesc;
+	Datum		values[3];
+	bool		nulls[3] = {false, false, false};
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	values[0] = Float8GetDatum(INSTR_TIME_GET_MILLISEC(elapsed));
+	values[1] = Int64GetDatum((int64) counters->totalspace);
+	values[2] = Int64GetDatum((int64) (counters->totalspace -
+									   counters->freespace));
+
+	return HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls));
+}
+
+/*
+ * Parse and plan a query once, then copy the plan 'nloops' times into a
+ * context of the given type.  copyObject() only ever allocates, like most
+ * of parse analysis and planning, so this is a fair model of how those
+ * stages use memory.  The memory figures are for the last copy.
+ */
+Datum
+bench_copy_plan(PG_FUNCTION_ARGS)
+{
+	char	   *context_type = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	char	   *query = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	int32		nloops = PG_GETARG_INT32(2);
+	List	   *raw_parsetree_list;
+	List	   *plantree_list = NIL;
+	ListCell   *lc;
+	MemoryContext bench_ctx;
+	MemoryContext old_ctx;
+	MemoryContextCounters counters;
+	instr_time	start;
+	instr_time	elapsed;
+	int			i;
+
+	if (nloops <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("nloops must be positive")));
+
+	raw_parsetree_list = pg_parse_query(query);
+	foreach(lc, raw_parsetree_list)
+	{
+		RawStmt    *parsetree = lfirst_node(RawStmt, lc);
+		List	   *querytree_list;
+
+		querytree_list = pg_analyze_and_rewrite(parsetree, query,
+												NULL, 0, NULL);
+		plantree_list = list_concat(plantree_list,
+									pg_plan_queries(querytree_list,
+													CURSOR_OPT_PARALLEL_OK,
+													NULL));
+	}
+
+	bench_ctx = create_bench_context(context_type, ALLOCSET_DEFAULT_INITSIZE);
+
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nloops; i++)
+	{
+		MemoryContextReset(bench_ctx);
+		old_ctx = MemoryContextSwitchTo(bench_ctx);
+		(void) copyObject(plantree_list);
+		MemoryContextSwitchTo(old_ctx);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start);
+
+	memset(&counters, 0, sizeof(counters));
+	bench_ctx->methods->stats(bench_ctx, NULL, NULL, &counters);
+	MemoryContextDelete(bench_ctx);
+
+	PG_RETURN_DATUM(make_bench_result(fcinfo, elapsed, &counters));
+}
+
+/*
+ * Store 'ntuples' tuples of 'tuple_width' bytes in a context of the given
+ * type, 'nloops' times, the way tuplesort.c or a hash table would.  The
+ * memory figures are for the last loop.
+ */
+Datum
+bench_store_tuples(PG_FUNCTION_ARGS)
+{
+	char	   *context_type = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	int32		ntuples = PG_GETARG_INT32(1);
+	int32		tuple_width = PG_GETARG_INT32(2);
+	int32		nloops = PG_GETARG_INT32(3);
+	void	  **tuples;
+	char	   *data;
+	MemoryContext bench_ctx;
+	MemoryContextCounters counters;
+	instr_time	start;
+	instr_time	elapsed;
+	int			i;
+	int			j;
+
+	if (ntuples <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("ntuples must be positive")));
+	if (tuple_width <= 0 || tuple_width > MaxAllocSize / 2)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("tuple_width is out of range")));
+	if (nloops <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("nloops must be positive")));
+
+	/* like tuplesort.c, cap generation.c blocks at 1/64th of work_mem */
+	bench_ctx = create_bench_context(context_type,
+									 Min(Max((Size) work_mem * 1024 / 64,
+											 ALLOCSET_DEFAULT_INITSIZE),
+										 ALLOCSET_DEFAULT_MAXSIZE));
+
+	tuples = palloc_extended(ntuples * sizeof(void *), MCXT_ALLOC_HUGE);
+	data = palloc0(tuple_width);
+
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nloops; i++)
+	{
+		MemoryContextReset(bench_ctx);
+		for (j = 0; j < ntuples; j++)
+		{
+			tuples[j] = MemoryContextAlloc(bench_ctx, tuple_width);
+			memcpy(tuples[j], data, tuple_width);
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start);
+
+	memset(&counters, 0, sizeof(counters));
+	bench_ctx->methods->stats(bench_ctx, NULL, NULL, &counters);
+	MemoryContextDelete(bench_ctx);
+	pfree(tuples);
+	pfree(data);
+
+	PG_RETURN_DATUM(make_bench_result(fcinfo, elapsed, &counters));
+}
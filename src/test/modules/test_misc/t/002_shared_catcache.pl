@@ -0,0 +1,72 @@
+# Check that the shared catalog cache doesn't hand out stale catalog rows
+# after DDL committed by another session, including once it is full.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 8;
+
+my $node = get_new_node('main');
+$node->init;
+# Small enough for the function definitions below to overflow it
+$node->append_conf('postgresql.conf', 'shared_catcache_size = 1MB');
+$node->start;
+
+# Each safe_psql() call below runs in a new session, whose own catcache is
+# empty, so its catalog lookups go through the shared cache.
+$node->safe_psql('postgres', 'CREATE TABLE sc_tab (a int)');
+my $oid = $node->safe_psql('postgres', "SELECT 'sc_tab'::regclass::oid");
+
+# Load the table's rows into the shared cache
+$node->safe_psql('postgres', 'SELECT a FROM sc_tab');
+
+$node->safe_psql('postgres', 'ALTER TABLE sc_tab RENAME TO sc_tab2');
+is($node->safe_psql('postgres', "SELECT $oid::regclass"),
+	'sc_tab2', 'renamed table is seen by a new session');
+is($node->safe_psql('postgres', "SELECT to_regclass('sc_tab') IS NULL"),
+	't', 'old table name is gone');
+
+$node->safe_psql('postgres', 'ALTER TABLE sc_tab2 RENAME COLUMN a TO b');
+my ($ret, $stdout, $stderr) =
+  $node->psql('postgres', 'SELECT a FROM sc_tab2');
+like($stderr, qr/column "a" does not exist/, 'old column name is gone');
+is($node->safe_psql('postgres', 'SELECT count(b) FROM sc_tab2'),
+	'0', 'renamed column is seen by a new session');
+
+# Fill the shared cache well beyond its size with function definitions
+$node->safe_psql(
+	'postgres', q{
+DO $$
+BEGIN
+  FOR i IN 1..2000 LOOP
+    EXECUTE format('CREATE FUNCTION sc_func_%s() RETURNS int LANGUAGE sql AS %L',
+                   i, 'SELECT ' || i || ' /* ' || repeat('x', 500) || ' */');
+  END LOOP;
+END
+$$});
+is( $node->safe_psql(
+		'postgres', 'SELECT count(oid::regprocedure::text) FROM pg_proc'),
+	$node->safe_psql('postgres', 'SELECT count(*) FROM pg_proc'),
+	'all functions can be looked up with a full shared cache');
+
+# Entries added after it filled up must be invalidated like the others
+$node->safe_psql('postgres', 'SELECT sc_func_1999()');
+$node->safe_psql('postgres',
+	'ALTER FUNCTION sc_func_1999() RENAME TO sc_func_renamed');
+is($node->safe_psql('postgres', 'SELECT sc_func_renamed()'),
+	'1999', 'renamed function is seen by a new session');
+($ret, $stdout, $stderr) = $node->psql('postgres', 'SELECT sc_func_1999()');
+like(
+	$stderr,
+	qr/function sc_func_1999\(\) does not exist/,
+	'old function name is gone');
+
+# Dropping a database removes its entries from the shared cache
+$node->safe_psql('postgres', 'CREATE DATABASE sc_db');
+$node->safe_psql('sc_db', 'SELECT count(oid::regprocedure::text) FROM pg_proc');
+$node->safe_psql('postgres', 'DROP DATABASE sc_db');
+is($node->safe_psql('postgres', 'SELECT sc_func_renamed()'),
+	'1999', 'cache still works after dropping a database');
+
+$node->stop;
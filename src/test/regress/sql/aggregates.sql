@@ -1060,3 +1060,15 @@ select v||'a', case when v||'a' = 'aa' then 1 else 0 end, count(*)
 explain (costs off)
   select 1 from tenk1
    where (hundred, thousand) in (select twothousand, twothousand from onek);
+
+-- Test hashed aggregation exceeding work_mem, which spills to disk
+set work_mem = '64kB';
+set enable_sort = false;
+explain (costs off)
+select g % 10000 as k, count(*) as c, sum(g::numeric) as s
+  from generate_series(1, 40000) g group by g % 10000;
+select count(*), sum(c), sum(s), min(s), max(s) from
+  (select g % 10000 as k, count(*) as c, sum(g::numeric) as s
+     from generate_series(1, 40000) g group by g % 10000) ss;
+reset enable_sort;
+reset work_mem;
@@ -0,0 +1,24 @@
+--
+-- INCREMENTAL SORT
+--
+create table incremental_sort_test (a int, b int);
+insert into incremental_sort_test
+  select i / 10, 10000 - i from generate_series(1, 10000) i;
+create index on incremental_sort_test (a);
+analyze incremental_sort_test;
+
+-- The index provides the leading sort key, so only groups need sorting
+explain (costs off)
+select * from incremental_sort_test order by a, b limit 10;
+select * from incremental_sort_test order by a, b limit 10;
+
+-- Batches span several groups of the presorted key
+select * from incremental_sort_test order by a, b desc limit 5 offset 25;
+
+-- Check that the planner respects enable_incremental_sort
+set enable_incremental_sort = off;
+explain (costs off)
+select * from incremental_sort_test order by a, b limit 10;
+reset enable_incremental_sort;
+
+drop table incremental_sort_test;
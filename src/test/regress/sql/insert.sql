@@ -604,3 +604,13 @@ alter table returningwrtest2 drop c;
 alter table returningwrtest attach partition returningwrtest2 for values in (2);
 insert into returningwrtest values (2, 'foo') returning returningwrtest;
 drop table returningwrtest;
+
+-- multi-row VALUES inserts into plain tables are batched; check that
+-- defaults, indexes and constraint violations still work as expected
+create table batchins (a serial primary key, b text, c int check (c > 0));
+insert into batchins (b, c) values ('one', 1), ('two', 2), (repeat('x', 10000), 3);
+select a, length(b), c from batchins order by a;
+insert into batchins (a, b, c) values (4, 'four', 4), (1, 'dup', 1);
+insert into batchins (b, c) values ('five', 5), ('bad', 0);
+select count(*) from batchins;
+drop table batchins;
@@ -292,6 +292,31 @@ $$
 $$);
 rollback to settings;
 
+-- A multi-batch inner join builds a bloom filter over the inner hash
+-- values, and drops outer tuples that can't match instead of writing them
+-- to a batch file.  Half of the outer rows here have no match.  The filter
+-- needs work_mem of at least 4MB.
+create table bloom_inner as
+  select generate_series(1, 100000) * 2 as id, 'aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa'::text as t;
+alter table bloom_inner set (parallel_workers = 0);
+analyze bloom_inner;
+create table bloom_outer as
+  select generate_series(1, 200000) as id, 'aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa'::text as t;
+alter table bloom_outer set (parallel_workers = 0);
+analyze bloom_outer;
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local enable_mergejoin = off;
+set local enable_nestloop = off;
+set local work_mem = '4MB';
+select count(*) from bloom_outer o join bloom_inner i using (id);
+select original > 1 as initially_multibatch, final > 1 as multibatch
+  from hash_join_batches(
+$$
+  select count(*) from bloom_outer o join bloom_inner i using (id);
+$$);
+rollback to settings;
+
 -- Exercise rescans.  We'll turn off parallel_leader_participation so
 -- that we can check that instrumentation comes back correctly.
 
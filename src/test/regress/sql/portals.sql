@@ -534,3 +534,21 @@ declare c2 scroll cursor for select generate_series(1,3) as g;
 fetch all in c2;
 fetch backward all in c2;
 rollback;
+
+-- A small sort or tuplestore must not allocate memory sized for work_mem
+-- up front
+set work_mem = '1GB';
+begin;
+declare c3 cursor for select g from generate_series(1, 100) g order by g desc;
+fetch 1 from c3;
+select count(*) > 0 as found, bool_and(total_bytes < 16384) as small
+  from pg_backend_memory_contexts where name = 'Caller tuples';
+commit;
+begin;
+declare c4 cursor with hold for select g from generate_series(1, 100) g;
+commit;
+select count(*) > 0 as found, bool_and(total_bytes < 16384) as small
+  from pg_backend_memory_contexts where name = 'Tuplestore tuples';
+fetch 1 from c4;
+close c4;
+reset work_mem;
@@ -0,0 +1,50 @@
+--
+-- RESULT CACHE
+--
+
+-- Run EXPLAIN ANALYZE, masking the memory usage of the cache, which
+-- depends on the platform
+create function explain_resultcache(query text) returns setof text
+language plpgsql as
+$$
+declare
+    ln text;
+begin
+    for ln in
+        execute format('explain (analyze, costs off, summary off, timing off) %s',
+            query)
+    loop
+        ln := regexp_replace(ln, 'Memory Usage: \d+', 'Memory Usage: N');
+        return next ln;
+    end loop;
+end;
+$$;
+
+create table rc_outer as select i % 10 as a from generate_series(1, 1000) i;
+create table rc_inner (a int primary key, b int);
+insert into rc_inner select i, i * 2 from generate_series(0, 999) i;
+analyze rc_outer;
+analyze rc_inner;
+
+set enable_resultcache = on;
+set enable_hashjoin = off;
+set enable_mergejoin = off;
+
+-- The outer side has only 10 distinct join keys, so only 10 index scans
+-- should be needed
+select explain_resultcache('
+select count(*), sum(i.b) from rc_outer o join rc_inner i on i.a = o.a');
+select count(*), sum(i.b) from rc_outer o join rc_inner i on i.a = o.a;
+
+-- A cross-type join clause: the cache must compare the int8 keys with the
+-- int8 member of the clause's operator family
+select explain_resultcache('
+select count(*), sum(i.b) from rc_outer o join rc_inner i on i.a = o.a::int8');
+select count(*), sum(i.b) from rc_outer o join rc_inner i on i.a = o.a::int8;
+
+reset enable_mergejoin;
+reset enable_hashjoin;
+reset enable_resultcache;
+
+drop table rc_outer, rc_inner;
+drop function explain_resultcache(text);
@@ -12,6 +12,21 @@ select count(*) >= 0 as ok from pg_available_extension_versions;
 
 select count(*) >= 0 as ok from pg_available_extensions;
 
+-- The catalog caches have surely been used by now
+select count(*) > 0 as ok, sum(hits) > 0 as hits_ok
+  from pg_backend_catcache_stats;
+
+-- Loading every function into a small catalog cache must evict entries
+set catalog_cache_memory_limit = '64kB';
+select count(oid::regprocedure::text) > 0 as ok from pg_proc;
+select sum(evictions) > 0 as ok from pg_backend_catcache_stats;
+reset catalog_cache_memory_limit;
+
+-- The entire output of pg_backend_memory_contexts is not stable,
+-- we test only the existence and basic condition of TopMemoryContext.
+select name, ident, parent, level, total_bytes >= free_bytes
+  from pg_backend_memory_contexts where level = 0;
+
 -- At introduction, pg_config had 23 entries; it may grow
 select count(*) > 20 as ok from pg_config;
 
@@ -32,6 +47,10 @@ select count(*) = 0 as ok from pg_prepared_statements;
 -- See also prepared_xacts.sql
 select count(*) >= 0 as ok from pg_prepared_xacts;
 
+-- Our own backend surely has some memory allocated
+select allocated_bytes > 0 as ok from pg_stat_memory_allocation
+  where pid = pg_backend_pid();
+
 -- This is to record the prevailing planner enable_foo settings during
 -- a regression test run.
 select name, setting from pg_settings where name like 'enable%';